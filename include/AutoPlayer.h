@@ -0,0 +1,347 @@
+//////////////////////////////////////////////////////////////////////////
+// AutoPlayer.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/Enums.h"
+#include "../include/Block.h"
+#include "../include/GameState.h"
+#include "../include/GamePolicy.h"
+#include "../include/PlacementKernels.h"
+
+// most placements of one block, every rotation in every column
+const int MAX_PLACEMENTS = 4 * MAX_BOARD_COLUMNS;
+
+// heuristic weights, tuned for the usual 10 wide board
+const double WEIGHT_HEIGHT = -0.510066;
+const double WEIGHT_LINES = 0.760666;
+const double WEIGHT_HOLES = -0.35663;
+const double WEIGHT_BUMPINESS = -0.184483;
+
+// locked squares as row masks of a board of any size, only the
+// used rows are copied for every candidate
+struct SearchBoard {
+	int columnCount;
+	int rowCount;
+	uint64_t fullRowMask;
+	uint64_t rows[MAX_BOARD_ROWS];
+};
+
+// where a block comes to rest, column and row of bounding box
+struct Placement {
+	int rotation;
+	int col;
+	int row;
+};
+
+// plays by moving every block to the placement with the best heuristic
+// score, looking at the focus block and the next block
+class AutoPlayer : public GamePolicy
+{
+public:
+	// constructor
+	AutoPlayer();
+
+	// prepare for a new game
+	void reset(uint64_t seed);
+
+	// get input that moves focus block toward its target
+	GameInput getInput(GameState* game);
+
+	// find best placement of focus block, false when no placement fits
+	bool findPlacement(GameState* game, Placement* placement);
+
+	// copy locked squares of playfield or of another board
+	static void copyBoard(Playfield* playfield, SearchBoard* board);
+	static void copyBoard(SearchBoard* source, SearchBoard* board);
+
+	// get placements reachable by turning in place, moving sideways
+	// and dropping, return number of placements, turns that only fit
+	// with a wall kick and slides under an overhang after the drop are
+	// not generated, so the players never plan kicks or tucks
+	static int getPlacements(SearchBoard* board, BlockTypes type, int rotation, int col, int row, Placement* placements);
+
+	// lock block into board and delete completed lines, return number of deleted lines
+	static int place(SearchBoard* board, BlockTypes type, Placement* placement);
+
+	// score board, higher is better
+	static double evaluate(SearchBoard* board, int lines);
+
+	// check if block overlaps squares, walls or bottom
+	static bool isColliding(SearchBoard* board, BlockTypes type, int rotation, int col, int row);
+
+	// get lowest row a block falls to from row, block must fit at row
+	static int getLandingRow(SearchBoard* board, BlockTypes type, int rotation, int col, int row);
+
+	// get mask of a bounding box row moved to column
+	static uint64_t getRowMask(BlockTypes type, int rotation, int boxRow, int col);
+
+protected:
+	// move focus block to this placement
+	void setTarget(Placement* placement);
+	void clearTarget();
+
+	// get input that moves focus block toward target
+	GameInput steer(Block* block);
+
+	// block the target is for
+	int mPlannedBlock;
+	bool mHasTarget;
+	Placement mTarget;
+
+	// position before last move, to notice moves that are blocked
+	bool mMoving;
+	int mLastCol;
+	int mLastRotation;
+};
+
+AutoPlayer::AutoPlayer()
+{
+	reset(0);
+}
+
+void AutoPlayer::reset(uint64_t /*seed*/) {
+	// play does not depend on seed, every game starts without a plan
+	mPlannedBlock = -1;
+	mHasTarget = false;
+	mMoving = false;
+	mLastCol = 0;
+	mLastRotation = 0;
+}
+
+GameInput AutoPlayer::getInput(GameState* game) {
+	// plan once for every block
+	if (mPlannedBlock != game->getBlockCount()) {
+		mPlannedBlock = game->getBlockCount();
+		Placement placement;
+		if (findPlacement(game, &placement)) {
+			setTarget(&placement);
+		} else {
+			clearTarget();
+		}
+	}
+	return steer(game->getFocusBlock());
+}
+
+void AutoPlayer::setTarget(Placement* placement) {
+	mTarget = *placement;
+	mHasTarget = true;
+	mMoving = false;
+}
+
+void AutoPlayer::clearTarget() {
+	mHasTarget = false;
+	mMoving = false;
+}
+
+GameInput AutoPlayer::steer(Block* block) {
+	if (!mHasTarget) {
+		return INPUT_DOWN;
+	}
+	// give up on target when last move did not change anything
+	if (mMoving && block->getColumn() == mLastCol && block->getRotation() == mLastRotation) {
+		mHasTarget = false;
+		return INPUT_DOWN;
+	}
+	mMoving = true;
+	mLastCol = block->getColumn();
+	mLastRotation = block->getRotation();
+
+	if (block->getRotation() != mTarget.rotation) {
+		return INPUT_ROTATE;
+	}
+	if (block->getColumn() < mTarget.col) {
+		return INPUT_RIGHT;
+	}
+	if (block->getColumn() > mTarget.col) {
+		return INPUT_LEFT;
+	}
+	// in place, drop
+	mMoving = false;
+	return INPUT_DOWN;
+}
+
+bool AutoPlayer::findPlacement(GameState* game, Placement* placement) {
+	SearchBoard board;
+	copyBoard(game->getPlayfield(), &board);
+	Block* block = game->getFocusBlock();
+	Block* next = game->getNextBlock();
+
+	Placement placements[MAX_PLACEMENTS];
+	Placement nextPlacements[MAX_PLACEMENTS];
+	int count = getPlacements(&board, block->getType(), block->getRotation(), block->getColumn(), block->getRow(), placements);
+	bool found = false;
+	double bestScore = 0;
+	for (int i = 0; i < count; i++) {
+		SearchBoard afterBlock;
+		copyBoard(&board, &afterBlock);
+		int lines = place(&afterBlock, block->getType(), &placements[i]);
+
+		// score of the best placement of next block from its start position
+		double score = evaluate(&afterBlock, lines);
+		int nextCount = getPlacements(&afterBlock, next->getType(), next->getRotation(), next->getColumn(), next->getRow(), nextPlacements);
+		for (int j = 0; j < nextCount; j++) {
+			SearchBoard afterNext;
+			copyBoard(&afterBlock, &afterNext);
+			int nextLines = place(&afterNext, next->getType(), &nextPlacements[j]);
+			double nextScore = evaluate(&afterNext, lines + nextLines);
+			if (j == 0 || nextScore > score) {
+				score = nextScore;
+			}
+		}
+		if (!found || score > bestScore) {
+			found = true;
+			bestScore = score;
+			*placement = placements[i];
+		}
+	}
+	return found;
+}
+
+void AutoPlayer::copyBoard(Playfield* playfield, SearchBoard* board) {
+	board->columnCount = playfield->getColumns();
+	board->rowCount = playfield->getRows();
+	board->fullRowMask = board->columnCount == 64 ? ~0ULL : (1ULL << board->columnCount) - 1;
+	for (int row = 0; row < board->rowCount; row++) {
+		board->rows[row] = playfield->getRowMask(row);
+	}
+}
+
+void AutoPlayer::copyBoard(SearchBoard* source, SearchBoard* board) {
+	// rows below row count are never read
+	board->columnCount = source->columnCount;
+	board->rowCount = source->rowCount;
+	board->fullRowMask = source->fullRowMask;
+	memcpy(board->rows, source->rows, source->rowCount * sizeof(uint64_t));
+}
+
+int AutoPlayer::getPlacements(SearchBoard* board, BlockTypes type, int rotation, int col, int row, Placement* placements) {
+	int count = 0;
+	KernelBoard kernelBoard;
+	PlacementKernels::loadBoard(board->rows, board->columnCount, board->rowCount, &kernelBoard);
+	// rotations that differ, the square block has one
+	int rotations = type == SQUARE_BLOCK ? 1 : 4;
+	for (int turns = 0; turns < rotations; turns++) {
+		int turned = (rotation + turns) & 3;
+		// drop straight down in every column at once
+		LandingBatch batch;
+		PlacementKernels::findLandings(&kernelBoard, type, turned, row, &batch);
+		int start = col - batch.firstCol;
+		if (start < 0 || start >= batch.count || batch.rows[start] == LANDING_BLOCKED) {
+			continue;
+		}
+		// every column reachable to the left and to the right
+		int first = start;
+		while (first > 0 && batch.rows[first - 1] != LANDING_BLOCKED) {
+			first--;
+		}
+		for (int lane = first; lane < batch.count && batch.rows[lane] != LANDING_BLOCKED; lane++) {
+			placements[count].rotation = turned;
+			placements[count].col = batch.firstCol + lane;
+			placements[count].row = batch.rows[lane];
+			count++;
+		}
+	}
+	return count;
+}
+
+int AutoPlayer::place(SearchBoard* board, BlockTypes type, Placement* placement) {
+	for (int i = 0; i < 4; i++) {
+		int row = placement->row + i;
+		if (row >= 0 && row < board->rowCount) {
+			board->rows[row] |= getRowMask(type, placement->rotation, i, placement->col);
+		}
+	}
+	// delete completed lines, move other rows down
+	int lines = 0;
+	for (int row = board->rowCount - 1; row >= 0; row--) {
+		if (board->rows[row] == board->fullRowMask) {
+			lines++;
+		} else if (lines > 0) {
+			board->rows[row + lines] = board->rows[row];
+		}
+	}
+	for (int row = 0; row < lines; row++) {
+		board->rows[row] = 0;
+	}
+	return lines;
+}
+
+double AutoPlayer::evaluate(SearchBoard* board, int lines) {
+	int height = 0;
+	int holes = 0;
+	int bumpiness = 0;
+	// columns with a square at or above row, a column counts once for
+	// every row from its top square to the bottom
+	uint64_t covered = 0;
+	// empty rows above the stack add nothing, tall boards skip them
+	int top = 0;
+	while (top < board->rowCount && board->rows[top] == 0) {
+		top++;
+	}
+	for (int row = top; row < board->rowCount; row++) {
+		uint64_t mask = board->rows[row];
+		// empty cells below a square
+		holes += Playfield::countBits(covered & ~mask);
+		covered |= mask;
+		height += Playfield::countBits(covered);
+		// neighbour columns differ in height by the rows where only one is covered
+		bumpiness += Playfield::countBits((covered ^ (covered >> 1)) & (board->fullRowMask >> 1));
+	}
+	return WEIGHT_HEIGHT * height + WEIGHT_LINES * lines + WEIGHT_HOLES * holes + WEIGHT_BUMPINESS * bumpiness;
+}
+
+bool AutoPlayer::isColliding(SearchBoard* board, BlockTypes type, int rotation, int col, int row) {
+	// outside walls
+	if (col + BLOCK_MASKS.left[type][rotation] < 0 || col + BLOCK_MASKS.right[type][rotation] >= board->columnCount) {
+		return true;
+	}
+	for (int i = 0; i < 4; i++) {
+		uint64_t mask = getRowMask(type, rotation, i, col);
+		if (mask == 0) {
+			continue;
+		}
+		int boardRow = row + i;
+		if (boardRow >= board->rowCount) {
+			return true;
+		}
+		if (boardRow >= 0 && (board->rows[boardRow] & mask) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int AutoPlayer::getLandingRow(SearchBoard* board, BlockTypes type, int rotation, int col, int row) {
+	// shift masks once, then test one row down at a time
+	uint64_t masks[4];
+	int bottom = 0;
+	for (int i = 0; i < 4; i++) {
+		masks[i] = getRowMask(type, rotation, i, col);
+		if (masks[i] != 0) {
+			bottom = i;
+		}
+	}
+	for (;; row++) {
+		int next = row + 1;
+		if (next + bottom >= board->rowCount) {
+			return row;
+		}
+		for (int i = 0; i <= bottom; i++) {
+			if (next + i >= 0 && (board->rows[next + i] & masks[i]) != 0) {
+				return row;
+			}
+		}
+	}
+}
+
+uint64_t AutoPlayer::getRowMask(BlockTypes type, int rotation, int boxRow, int col) {
+	uint64_t mask = BLOCK_MASKS.rows[type][rotation][boxRow];
+	// shift right for bounding boxes that start left of the wall
+	return col >= 0 ? mask << col : mask >> -col;
+}
\ No newline at end of file
@@ -4,54 +4,247 @@
 
 #pragma once
 
-#include "../include/Square.h"
+#include <cstdint>
 
-// class for Block
+#include "../include/Constants.h"
+#include "../include/Enums.h"
+
+// number of wall kick candidates tried for a rotation
+const int KICK_TESTS = 5;
+
+// cells of a block
+struct BlockPose {
+	// column and row of four squares
+	int col[4];
+	int row[4];
+};
+
+// cells of spawn orientation inside bounding box,
+// (column, row) with rows counted downward
+constexpr int BLOCK_SHAPES[BLOCK_TOTAL][4][2] = {
+	// [0][1]
+	// [2][3]
+	{ { 0,0 },{ 1,0 },{ 0,1 },{ 1,1 } },
+	//       [0]
+	// [1][2][3]
+	{ { 2,0 },{ 0,1 },{ 1,1 },{ 2,1 } },
+	// [0]
+	// [1][2][3]
+	{ { 0,0 },{ 0,1 },{ 1,1 },{ 2,1 } },
+	//    [0]
+	// [1][2][3]
+	{ { 1,0 },{ 0,1 },{ 1,1 },{ 2,1 } },
+	//    [0][1]
+	// [2][3]
+	{ { 1,0 },{ 2,0 },{ 0,1 },{ 1,1 } },
+	// [0][1]
+	//    [2][3]
+	{ { 0,0 },{ 1,0 },{ 1,1 },{ 2,1 } },
+	//
+	// [0][1][2][3]
+	{ { 0,1 },{ 1,1 },{ 2,1 },{ 3,1 } }
+};
+
+// size of bounding box, blocks turn around its center
+constexpr int BLOCK_BOX_SIZE[BLOCK_TOTAL] = { 2, 3, 3, 3, 3, 3, 4 };
+
+// wall kick offsets (column, row) tried in order when turning clockwise
+// from a rotation, the first one is no kick, turning counterclockwise
+// uses the negated offsets of the opposite turn
+constexpr int BLOCK_KICKS[3][4][KICK_TESTS][2] = {
+	// square block never kicks
+	{
+		{ { 0,0 },{ 0,0 },{ 0,0 },{ 0,0 },{ 0,0 } },
+		{ { 0,0 },{ 0,0 },{ 0,0 },{ 0,0 },{ 0,0 } },
+		{ { 0,0 },{ 0,0 },{ 0,0 },{ 0,0 },{ 0,0 } },
+		{ { 0,0 },{ 0,0 },{ 0,0 },{ 0,0 },{ 0,0 } }
+	},
+	// three wide blocks
+	{
+		{ { 0,0 },{ -1,0 },{ -1,-1 },{ 0,2 },{ -1,2 } },
+		{ { 0,0 },{ 1,0 },{ 1,1 },{ 0,-2 },{ 1,-2 } },
+		{ { 0,0 },{ 1,0 },{ 1,-1 },{ 0,2 },{ 1,2 } },
+		{ { 0,0 },{ -1,0 },{ -1,1 },{ 0,-2 },{ -1,-2 } }
+	},
+	// straight block
+	{
+		{ { 0,0 },{ -2,0 },{ 1,0 },{ -2,1 },{ 1,-2 } },
+		{ { 0,0 },{ -1,0 },{ 2,0 },{ -1,-2 },{ 2,1 } },
+		{ { 0,0 },{ 2,0 },{ -1,0 },{ 2,-1 },{ -1,2 } },
+		{ { 0,0 },{ 1,0 },{ -2,0 },{ 1,2 },{ -2,-1 } }
+	}
+};
+
+// kick table of every block type
+constexpr int BLOCK_KICK_TABLE[BLOCK_TOTAL] = { 0, 1, 1, 1, 1, 1, 2 };
+
+// cells of every block type in every rotation
+struct BlockRotationTable {
+	int cells[BLOCK_TOTAL][4][4][2];
+};
+
+// every rotation turns the previous one clockwise inside bounding box
+constexpr BlockRotationTable makeRotationTable() {
+	BlockRotationTable table = {};
+	for (int type = 0; type < BLOCK_TOTAL; type++) {
+		int size = BLOCK_BOX_SIZE[type];
+		for (int i = 0; i < 4; i++) {
+			table.cells[type][0][i][0] = BLOCK_SHAPES[type][i][0];
+			table.cells[type][0][i][1] = BLOCK_SHAPES[type][i][1];
+		}
+		for (int rotation = 1; rotation < 4; rotation++) {
+			for (int i = 0; i < 4; i++) {
+				table.cells[type][rotation][i][0] = size - 1 - table.cells[type][rotation - 1][i][1];
+				table.cells[type][rotation][i][1] = table.cells[type][rotation - 1][i][0];
+			}
+		}
+	}
+	return table;
+}
+
+constexpr BlockRotationTable BLOCK_ROTATIONS = makeRotationTable();
+
+// check if two rotations cover the same cells
+constexpr bool isSameRotation(int type, int first, int second) {
+	for (int i = 0; i < 4; i++) {
+		bool found = false;
+		for (int j = 0; j < 4; j++) {
+			if (BLOCK_ROTATIONS.cells[type][first][i][0] == BLOCK_ROTATIONS.cells[type][second][j][0] &&
+				BLOCK_ROTATIONS.cells[type][first][i][1] == BLOCK_ROTATIONS.cells[type][second][j][1]) {
+				found = true;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// check if every rotation has four different cells inside bounding box
+constexpr bool isRotationTableValid() {
+	for (int type = 0; type < BLOCK_TOTAL; type++) {
+		for (int rotation = 0; rotation < 4; rotation++) {
+			for (int i = 0; i < 4; i++) {
+				int col = BLOCK_ROTATIONS.cells[type][rotation][i][0];
+				int row = BLOCK_ROTATIONS.cells[type][rotation][i][1];
+				if (col < 0 || col >= BLOCK_BOX_SIZE[type] || row < 0 || row >= BLOCK_BOX_SIZE[type]) {
+					return false;
+				}
+				for (int j = 0; j < i; j++) {
+					if (col == BLOCK_ROTATIONS.cells[type][rotation][j][0] && row == BLOCK_ROTATIONS.cells[type][rotation][j][1]) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// check if the first kick of every rotation is no kick
+constexpr bool isKickTableValid() {
+	for (int table = 0; table < 3; table++) {
+		for (int rotation = 0; rotation < 4; rotation++) {
+			if (BLOCK_KICKS[table][rotation][0][0] != 0 || BLOCK_KICKS[table][rotation][0][1] != 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static_assert(isRotationTableValid(), "every rotation needs four squares inside bounding box");
+static_assert(isKickTableValid(), "first wall kick must keep block in place");
+static_assert(isSameRotation(SQUARE_BLOCK, 0, 1) && isSameRotation(SQUARE_BLOCK, 0, 2), "square block does not change when rotated");
+static_assert(isSameRotation(S_BLOCK, 1, 3) == false && isSameRotation(STRAIGHT_BLOCK, 0, 2) == false, "two wide rotations sit in different cells");
+static_assert(BLOCK_ROTATIONS.cells[T_BLOCK][1][0][0] == 2 && BLOCK_ROTATIONS.cells[T_BLOCK][1][0][1] == 1, "T block points right after one turn");
+static_assert(BLOCK_ROTATIONS.cells[STRAIGHT_BLOCK][1][0][0] == 2 && BLOCK_ROTATIONS.cells[STRAIGHT_BLOCK][3][0][0] == 1, "straight block stands in inner columns");
+
+// row masks of every block type in every rotation, for bitboard tests
+struct BlockMaskTable {
+	// bit n of a row is set when column n of bounding box is used
+	uint16_t rows[BLOCK_TOTAL][4][4];
+	// first and last used column of bounding box
+	int left[BLOCK_TOTAL][4];
+	int right[BLOCK_TOTAL][4];
+};
+
+constexpr BlockMaskTable makeMaskTable() {
+	BlockMaskTable table = {};
+	for (int type = 0; type < BLOCK_TOTAL; type++) {
+		for (int rotation = 0; rotation < 4; rotation++) {
+			table.left[type][rotation] = 3;
+			table.right[type][rotation] = 0;
+			for (int i = 0; i < 4; i++) {
+				int col = BLOCK_ROTATIONS.cells[type][rotation][i][0];
+				int row = BLOCK_ROTATIONS.cells[type][rotation][i][1];
+				table.rows[type][rotation][row] |= (uint16_t)(1 << col);
+				table.left[type][rotation] = col < table.left[type][rotation] ? col : table.left[type][rotation];
+				table.right[type][rotation] = col > table.right[type][rotation] ? col : table.right[type][rotation];
+			}
+		}
+	}
+	return table;
+}
+
+constexpr BlockMaskTable BLOCK_MASKS = makeMaskTable();
+
+static_assert(BLOCK_MASKS.rows[STRAIGHT_BLOCK][0][1] == 0xF && BLOCK_MASKS.rows[T_BLOCK][0][0] == 0x2, "masks follow rotation table");
+
+// class for Block, position is the top left cell of bounding box
 class Block
 {
 public:
 	// constructor
 	Block();
-	Block(int x, int y, LTexture* texture, BlockTypes type);
+	Block(BlockTypes type);
 
-	// set position of squares
-	void setupSquares(int x, int y);
+	// set type and move to start position of a board with cols columns,
+	// used to reuse pooled blocks
+	void init(BlockTypes type, int cols = SQUARES_PER_ROW);
 
-	// draw block
-	void draw(SDL_Renderer* renderer);
+	// set position of bounding box and spawn rotation
+	void setPosition(int col, int row);
 
 	// move block
 	void move(Direction dir);
+	void move(int cols, int rows);
+
+	// rotate block clockwise
+	void rotate(int turns = 1);
 
-	// rotate block
-	void rotate();
+	// get cells of block
+	BlockPose getPose();
 
-	// get rotate block position
-	int* getRotatePosition();
+	// get cells after turns of rotation, block is not changed
+	BlockPose getRotatePosition(int turns = 1);
 
-	// get squares
-	// we will save square pointer in vector and can not deallocate
-	// it in destructor, so we deallocate by get the pointer
-	Square** getSquares();
+	// getter
+	BlockTypes getType();
+	int getRotation();
+	int getColumn();
+	int getRow();
+
+	// get wall kick offset of a clockwise turn from current rotation
+	int getKickColumn(int test);
+	int getKickRow(int test);
 
 	~Block();
 
 private:
-	// center position
-	int mCenterX;
-	int mCenterY;
+	// get cells of block in a rotation
+	BlockPose getPose(int rotation);
+
+	// position of bounding box
+	int mCol;
+	int mRow;
 
-	// squares
-	Square* mSquares[4];
 	BlockTypes mBlockType;
-public:
-	// clips for squares
-	static SDL_Rect sBlockClips[BLOCK_TOTAL];
+	// number of turns from spawn rotation
+	int mRotation;
 };
 
-// init static clips
-SDL_Rect Block::sBlockClips[BLOCK_TOTAL];
-
 Block::Block()
 {
 }
@@ -60,151 +253,87 @@ Block::~Block()
 {
 }
 
-Block::Block(int x, int y, LTexture* texture, BlockTypes type):
-	mCenterX(x),mCenterY(y),mBlockType(type){
-	for (int i = 0; i < 4; i++) {
-		mSquares[i] = new Square(x, y, texture, &sBlockClips[type]);
-	}
-	// set squares position
-	setupSquares(x, y);
+Block::Block(BlockTypes type) {
+	init(type);
 }
 
-void Block::setupSquares(int x, int y) {
-	mCenterX = x;
-	mCenterY = y;
-	switch (mBlockType)
-	{
-	case SQUARE_BLOCK:
-		// [0][1]
-		// [2][3]
-		mSquares[0]->setCenter(x - SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		break;
-	case L_BLOCK:
-		// [0]
-		// [1]
-		// [2][3]
-		mSquares[0]->setCenter(x - SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN*3);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN*3);
-		break;
-	case BACKWORDS_L_BLOCK:
-		//    [0]
-		//    [1]
-		// [2][3]
-		mSquares[0]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN*3);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN*3);
-		break;
-	case T_BLOCK:
-		//    [0]
-		// [1][2][3]
-		mSquares[0]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN*3, y + SQUARE_MEDIAN);
-		break;
-	case S_BLOCK:
-		//    [0][1]
-		// [2][3]
-		mSquares[0]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x + SQUARE_MEDIAN*3, y - SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x - SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		break;
-	case BACKWARDS_S_BLOCK:
-		// [0][1]
-		//    [2][3]
-		mSquares[0]->setCenter(x - SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[1]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN*3, y + SQUARE_MEDIAN);
-		break;
-	case STRAIGHT_BLOCK:
-		// [0]
-		// [1]
-		// [2]
-		// [3]
-		mSquares[0]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN*3);
-		mSquares[1]->setCenter(x + SQUARE_MEDIAN, y - SQUARE_MEDIAN);
-		mSquares[2]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN);
-		mSquares[3]->setCenter(x + SQUARE_MEDIAN, y + SQUARE_MEDIAN*3);
-		break;
-	default:
-		break;
-	}
+void Block::init(BlockTypes type, int cols) {
+	mBlockType = type;
+	// blocks start centered in the first visible row
+	setPosition((cols - BLOCK_BOX_SIZE[type]) / 2, BLOCK_START_ROW);
 }
 
-void Block::draw(SDL_Renderer* renderer) {
-	for (int i = 0; i < 4; i++) {
-		mSquares[i]->draw(renderer);
-	}
+void Block::setPosition(int col, int row) {
+	mCol = col;
+	mRow = row;
+	mRotation = 0;
 }
 
 void Block::move(Direction dir) {
-	int distance = SQUARE_MEDIAN * 2;
-	// move block center
 	switch (dir)
 	{
 	case LEFT:
-		mCenterX -= distance;
+		mCol--;
 		break;
 	case RIGHT:
-		mCenterX += distance;
+		mCol++;
 		break;
 	case DOWN:
-		mCenterY += distance;
+		mRow++;
 		break;
 	default:
 		break;
 	}
-	// move squares
-	for (int i = 0; i < 4; i++) {
-		mSquares[i]->move(dir);
-	}
 }
 
-void Block::rotate() {
-	int x1, x2, y1, y2;
-	for (int i = 0; i < 4; i++) {
-		// get square position
-		x1 = mSquares[i]->getCenterX();
-		y1 = mSquares[i]->getCenterY();
-		// origin
-		x1 -= mCenterX;
-		y1 -= mCenterY;
-
-		// rotate
-		x2 = -y1 + mCenterX;
-		y2 = x1 + mCenterY;
-		mSquares[i]->setCenter(x2, y2);
-	}
+void Block::move(int cols, int rows) {
+	mCol += cols;
+	mRow += rows;
+}
+
+void Block::rotate(int turns) {
+	// rotation is only an index into the table
+	mRotation = (mRotation + turns) & 3;
 }
 
-int* Block::getRotatePosition() {
-	int* temp = new int[8];
-	int x1, x2, y1, y2;
+BlockPose Block::getPose() {
+	return getPose(mRotation);
+}
+
+BlockPose Block::getRotatePosition(int turns) {
+	return getPose((mRotation + turns) & 3);
+}
+
+BlockPose Block::getPose(int rotation) {
+	BlockPose pose;
+	const int (*cells)[2] = BLOCK_ROTATIONS.cells[mBlockType][rotation];
 	for (int i = 0; i < 4; i++) {
-		// get square position
-		x1 = mSquares[i]->getCenterX();
-		y1 = mSquares[i]->getCenterY();
-		// origin
-		x1 -= mCenterX;
-		y1 -= mCenterY;
-
-		// rotate
-		x2 = -y1 + mCenterX;
-		y2 = x1 + mCenterY;
-		temp[i * 2] = x2;
-		temp[i * 2 + 1] = y2;
+		pose.col[i] = mCol + cells[i][0];
+		pose.row[i] = mRow + cells[i][1];
 	}
-	return temp;
+	return pose;
+}
+
+BlockTypes Block::getType() {
+	return mBlockType;
+}
+
+int Block::getRotation() {
+	return mRotation;
+}
+
+int Block::getColumn() {
+	return mCol;
+}
+
+int Block::getRow() {
+	return mRow;
+}
+
+int Block::getKickColumn(int test) {
+	return BLOCK_KICKS[BLOCK_KICK_TABLE[mBlockType]][mRotation][test][0];
 }
 
-Square** Block::getSquares() {
-	return mSquares;
+int Block::getKickRow(int test) {
+	return BLOCK_KICKS[BLOCK_KICK_TABLE[mBlockType]][mRotation][test][1];
 }
\ No newline at end of file
@@ -10,21 +10,57 @@ const int WINDOW_WIDTH = 300;
 const int WINDOW_HEIGHT = 400;
 const char* WINDOW_CAPTION = "Falling Blocks";
 
+// replay of the last game
+const char* REPLAY_PATH = "last_game.replay";
+
 // game setting
 const int FRAMES_PER_SECOND = 60;
-const int FRAME_RATE = 1000/FRAMES_PER_SECOND;
+const int MAX_TICKS_PER_FRAME = 5;
+const bool ENABLE_VSYNC = false;
 
-// force speed
-const int INITIAL_SPEED = 60;
-const int SPEED_CHANGE = 12;
-const int SLIDE_TIME = 15;
+// force speed, in milliseconds per square
+const int INITIAL_SPEED = 1000;
+const int SPEED_CHANGE = 200;
+// time a landed block can still slide, in milliseconds
+const int SLIDE_TIME = 250;
 // score
 const int POINTS_PER_LINE = 500;
 const int POINTS_PER_LEVEL = 6000;
-const int LEVEL_NUMS = 5;
-// square related setting
+// gravity in squares per tick, 16.16 fixed point
+const int GRAVITY_ONE = 1 << 16;
+const int GRAVITY_20G = 20 * GRAVITY_ONE;
+// gravity of a force speed, rounded up so a square takes as many ticks as before
+constexpr int gravityFromSpeed(int milliseconds) {
+	return (GRAVITY_ONE * 1000 + milliseconds * FRAMES_PER_SECOND - 1) / (milliseconds * FRAMES_PER_SECOND);
+}
+// gravity of every level, levels past the table keep its last gravity
+const int GRAVITY_LEVELS = 13;
+constexpr int LEVEL_GRAVITY[GRAVITY_LEVELS] = {
+	gravityFromSpeed(INITIAL_SPEED),
+	gravityFromSpeed(INITIAL_SPEED - SPEED_CHANGE),
+	gravityFromSpeed(INITIAL_SPEED - 2 * SPEED_CHANGE),
+	gravityFromSpeed(INITIAL_SPEED - 3 * SPEED_CHANGE),
+	gravityFromSpeed(INITIAL_SPEED - 4 * SPEED_CHANGE),
+	gravityFromSpeed(100),
+	gravityFromSpeed(50),
+	GRAVITY_ONE,
+	2 * GRAVITY_ONE,
+	3 * GRAVITY_ONE,
+	5 * GRAVITY_ONE,
+	10 * GRAVITY_ONE,
+	GRAVITY_20G
+};
+// game is won after the last level, every gravity of the table is played
+const int LEVEL_NUMS = GRAVITY_LEVELS;
+// number of next blocks shown in advance
+const int PREVIEW_COUNT = 3;
+// blocks alive at once, the falling block and the next blocks
+const int BLOCK_POOL_SIZE = PREVIEW_COUNT + 1;
+// square related setting, columns of the default board
 const int SQUARES_PER_ROW = 10;
 const int SQUARE_MEDIAN = 10;
+// opacity of ghost block showing where focus block lands
+const int GHOST_ALPHA = 0x60;
 
 // game level background coordinate
 const int LEVEL_ONE_X = 0;
@@ -48,12 +84,31 @@ const int SCORE_RECT_X = 40;
 const int SCORE_RECT_Y = 340;
 const int NEEDED_SCORE_RECT_X = 40;
 const int NEEDED_SCORE_RECT_Y = 360;
-// block start coordinate and next block circle coordinate
-const int BLOCK_START_X = 150;
-const int BLOCK_START_Y = 60;
+// next block circle coordinate
 const int NEXT_BLOCK_CIRCLE_X = 210;
 const int NEXT_BLOCK_CIRCLE_Y = 340;
+// later blocks of preview queue, smaller and stacked right of the circle
+const int PREVIEW_QUEUE_X = 275;
+const int PREVIEW_QUEUE_Y = 325;
+const int PREVIEW_QUEUE_SPACING = 40;
+const int PREVIEW_SQUARE_MEDIAN = 5;
+static_assert(PREVIEW_QUEUE_Y + (PREVIEW_COUNT - 2) * PREVIEW_QUEUE_SPACING + 4 * PREVIEW_SQUARE_MEDIAN <= WINDOW_HEIGHT,
+	"preview queue fits in window");
 // game area
 const int GAME_AREA_LEFT = 50;
 const int GAME_AREA_RIGHT = 250;
-const int GAME_AREA_BOTTOM = 300;
\ No newline at end of file
+const int GAME_AREA_BOTTOM = 300;
+// playfield rows, hidden rows sit above the visible game area
+// and catch squares of blocks locked right after spawning
+const int PLAYFIELD_VISIBLE_ROWS = 13;
+const int PLAYFIELD_HIDDEN_ROWS = 2;
+const int PLAYFIELD_ROWS = PLAYFIELD_VISIBLE_ROWS + PLAYFIELD_HIDDEN_ROWS;
+const int GAME_AREA_TOP = GAME_AREA_BOTTOM - PLAYFIELD_VISIBLE_ROWS * SQUARE_MEDIAN * 2;
+// board size can be changed at runtime, a row is one 64 bit word,
+// the smallest board fits every block below the hidden rows
+const int MIN_BOARD_COLUMNS = 4;
+const int MAX_BOARD_COLUMNS = 64;
+const int MIN_BOARD_ROWS = PLAYFIELD_HIDDEN_ROWS + 4;
+const int MAX_BOARD_ROWS = 256;
+// row of bounding box top when a block starts falling
+const int BLOCK_START_ROW = PLAYFIELD_HIDDEN_ROWS;
\ No newline at end of file
@@ -19,4 +19,33 @@ enum Direction {
 	LEFT,
 	RIGHT,
 	DOWN
+};
+
+enum GameInput {
+	INPUT_NONE,
+	INPUT_ROTATE,
+	INPUT_LEFT,
+	INPUT_RIGHT,
+	INPUT_DOWN,
+	INPUT_HARD_DROP,
+	INPUT_TOTAL
+};
+
+// flags returned by game steps
+enum GameEvents {
+	EVENT_NONE = 0,
+	EVENT_MOVED = 1 << 0,
+	EVENT_BLOCKED = 1 << 1,
+	EVENT_LOCKED = 1 << 2,
+	EVENT_LINES_CLEARED = 1 << 3,
+	EVENT_WIN = 1 << 4,
+	EVENT_LOSS = 1 << 5
+};
+
+// instruction sets of placement kernels, higher is faster
+enum KernelLevel {
+	KERNEL_SCALAR,
+	KERNEL_SSE2,
+	KERNEL_AVX2,
+	KERNEL_TOTAL
 };
\ No newline at end of file
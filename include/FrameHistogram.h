@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////
+// FrameHistogram.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+// width of histogram bucket in microseconds
+const int HISTOGRAM_BUCKET_WIDTH = 100;
+// number of buckets, longer frames go into the last one
+const int HISTOGRAM_BUCKETS = 1000;
+
+// histogram of frame times with fixed buckets, recording
+// a frame is constant time and never allocates
+class FrameHistogram
+{
+public:
+	// constructor
+	FrameHistogram();
+
+	// remove all recorded frames
+	void reset();
+
+	// record frame time in microseconds
+	void record(unsigned int frameTime);
+
+	// get frame time in microseconds at percentile (0 to 100),
+	// accurate to bucket width
+	unsigned int getPercentile(double percentile);
+
+	// getter
+	unsigned int getCount();
+	unsigned int getMax();
+
+	// print p50, p99 and max
+	void print(FILE* file);
+
+private:
+	// frames per bucket
+	unsigned int mBuckets[HISTOGRAM_BUCKETS];
+	unsigned int mCount;
+	unsigned int mMax;
+};
+
+FrameHistogram::FrameHistogram()
+{
+	reset();
+}
+
+void FrameHistogram::reset() {
+	memset(mBuckets, 0, sizeof(mBuckets));
+	mCount = 0;
+	mMax = 0;
+}
+
+void FrameHistogram::record(unsigned int frameTime) {
+	unsigned int bucket = frameTime / HISTOGRAM_BUCKET_WIDTH;
+	if (bucket >= HISTOGRAM_BUCKETS) {
+		bucket = HISTOGRAM_BUCKETS - 1;
+	}
+	mBuckets[bucket]++;
+	mCount++;
+	if (frameTime > mMax) {
+		mMax = frameTime;
+	}
+}
+
+unsigned int FrameHistogram::getPercentile(double percentile) {
+	if (mCount == 0) {
+		return 0;
+	}
+	// number of frames at or below the result
+	unsigned int rank = (unsigned int)(percentile / 100.0 * mCount + 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	unsigned int accumulation = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		accumulation += mBuckets[i];
+		if (accumulation >= rank) {
+			// upper bound of bucket, but never above the real max
+			unsigned int upper = (i + 1) * HISTOGRAM_BUCKET_WIDTH;
+			return upper < mMax ? upper : mMax;
+		}
+	}
+	return mMax;
+}
+
+unsigned int FrameHistogram::getCount() {
+	return mCount;
+}
+
+unsigned int FrameHistogram::getMax() {
+	return mMax;
+}
+
+void FrameHistogram::print(FILE* file) {
+	fprintf(file, "Frames: %u, p50: %.1f ms, p99: %.1f ms, max: %.1f ms\n",
+		mCount, getPercentile(50) / 1000.0, getPercentile(99) / 1000.0, mMax / 1000.0);
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////
+// FrameScheduler.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <SDL/SDL.h>
+
+#include "../include/Constants.h"
+#include "../include/FrameHistogram.h"
+
+// fixed timestep scheduler, simulation ticks are due at absolute
+// deadlines and the main loop sleeps until the next one
+class FrameScheduler
+{
+public:
+	// constructor
+	FrameScheduler();
+
+	// start counting ticks from now
+	void start();
+
+	// get number of simulation ticks due since last call
+	int consumeTicks();
+
+	// sleep until deadline of next tick has passed
+	void waitForNextFrame();
+
+	// get recorded frame times
+	FrameHistogram* getFrameTimes();
+
+private:
+	// get performance counter since start
+	Uint64 getElapsed();
+
+	// get performance counter of tick deadline since start
+	Uint64 getDeadline(Uint64 tick);
+
+	// performance counter frequency
+	Uint64 mFrequency;
+	// performance counter at start and at last frame
+	Uint64 mStartTime;
+	Uint64 mFrameTime;
+	// number of consumed ticks
+	Uint64 mTickCount;
+
+	// time between frames
+	FrameHistogram mFrameTimes;
+};
+
+FrameScheduler::FrameScheduler():
+	mFrequency(0),mStartTime(0),mFrameTime(0),mTickCount(0){
+}
+
+void FrameScheduler::start() {
+	mFrequency = SDL_GetPerformanceFrequency();
+	mStartTime = SDL_GetPerformanceCounter();
+	mTickCount = 0;
+	if (mFrameTime == 0) {
+		mFrameTime = mStartTime;
+	}
+}
+
+int FrameScheduler::consumeTicks() {
+	// ticks whose deadline has passed
+	Uint64 due = getElapsed() * FRAMES_PER_SECOND / mFrequency;
+	Uint64 ticks = due - mTickCount;
+	// drop ticks after a long stall instead of catching up at once
+	if (ticks > MAX_TICKS_PER_FRAME) {
+		ticks = MAX_TICKS_PER_FRAME;
+	}
+	mTickCount = due;
+	return (int)ticks;
+}
+
+void FrameScheduler::waitForNextFrame() {
+	Uint64 elapsed = getElapsed();
+	// next deadline after now, also when ticks are not consumed
+	Uint64 due = elapsed * FRAMES_PER_SECOND / mFrequency;
+	Uint64 deadline = getDeadline(due + 1);
+	// give the processor away until the deadline has passed, delay is
+	// rounded up so the loop never runs again before it
+	while (elapsed < deadline) {
+		SDL_Delay((Uint32)(((deadline - elapsed) * 1000 + mFrequency - 1) / mFrequency));
+		elapsed = getElapsed();
+	}
+
+	// record time since last frame, every frame ends at a deadline
+	Uint64 now = SDL_GetPerformanceCounter();
+	mFrameTimes.record((unsigned int)((now - mFrameTime) * 1000000 / mFrequency));
+	mFrameTime = now;
+}
+
+FrameHistogram* FrameScheduler::getFrameTimes() {
+	return &mFrameTimes;
+}
+
+Uint64 FrameScheduler::getElapsed() {
+	return SDL_GetPerformanceCounter() - mStartTime;
+}
+
+Uint64 FrameScheduler::getDeadline(Uint64 tick) {
+	// computed from tick number, so deadlines never drift
+	return (tick * mFrequency + FRAMES_PER_SECOND - 1) / FRAMES_PER_SECOND;
+}
\ No newline at end of file
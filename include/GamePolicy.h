@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////
+// GamePolicy.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "../include/Enums.h"
+#include "../include/GameState.h"
+
+// base class for anything that plays a game instead of the keyboard,
+// every game needs its own policy object
+class GamePolicy
+{
+public:
+	virtual ~GamePolicy() {}
+
+	// prepare for a new game
+	virtual void reset(uint64_t seed) = 0;
+
+	// get input to apply before next tick, INPUT_NONE to let the block fall
+	virtual GameInput getInput(GameState* game) = 0;
+};
\ No newline at end of file
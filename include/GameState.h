@@ -0,0 +1,422 @@
+//////////////////////////////////////////////////////////////////////////
+// GameState.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "../include/Constants.h"
+#include "../include/Enums.h"
+#include "../include/Block.h"
+#include "../include/Playfield.h"
+#include "../include/ObjectPool.h"
+#include "../include/Random.h"
+
+// class for game logic, it does not depend on SDL,
+// the game is stepped by input and fixed ticks
+class GameState
+{
+public:
+	// constructor
+	GameState();
+
+	// start a new game, same seed and inputs give the same game
+	void reset(uint64_t seed);
+
+	// change board size, clamped to board limits, the playfield is
+	// emptied and blocks keep the old size until reset starts a new game
+	void setBoardSize(int cols, int rows);
+
+	// start game at a later level, call after reset
+	void setLevel(int level);
+
+	// apply player input, return game events
+	int handleInput(GameInput input);
+
+	// advance game by one tick, return game events
+	int update();
+
+	// getter
+	Playfield* getPlayfield();
+	Block* getFocusBlock();
+	// get block coming after index other blocks, 0 is the next block
+	Block* getNextBlock(int index = 0);
+	int getScore();
+	int getLevel();
+	int getLines();
+	int getTicks();
+	// get number of blocks that started falling
+	int getBlockCount();
+	uint64_t getSeed();
+	// get row of focus block after dropping it, where its ghost is drawn
+	int getLandingRow();
+	bool isOver();
+
+	// check if the time of ticks reaches milliseconds
+	static bool isElapsed(int ticks, int milliseconds);
+
+	// get gravity of a level, squares per tick as 16.16 fixed point
+	static int getLevelGravity(int level);
+
+private:
+	// get a block from pool
+	Block* createBlock(BlockTypes type);
+
+	// helper functions
+	int handleBottomCollision();
+	void changeFoculBlock();
+	int checkCompletedLindes();
+	bool checkWin();
+	bool checkLoss();
+
+	// collision detection
+	bool checkCollisions(BlockPose* pose, int cols, int rows);
+	bool checkCollisions(Block* block, Direction dir);
+	// get first wall kick that lets block rotate, -1 when all are blocked
+	int checkRotationCollisions(Block* block);
+
+	// locked squares
+	Playfield mPlayfield;
+
+	// storage for blocks, no block is allocated during game
+	ObjectPool<Block, BLOCK_POOL_SIZE> mBlockPool;
+
+	// falling block
+	Block* mFocusBlock;
+	// next blocks in a ring, mPreviewStart is the next one
+	Block* mPreview[PREVIEW_COUNT];
+	int mPreviewStart;
+
+	int mBlockCount;
+
+	// block types come from a seeded bag
+	BlockBag mBag;
+	uint64_t mSeed;
+
+	// score, level and cleared lines
+	int mScore;
+	int mLevel;
+	int mLines;
+	int mGravity;
+
+	// ticks since start and since block landed
+	int mTicks;
+	int mSlideTicks;
+	// gravity gathered since last force down, a square for every GRAVITY_ONE
+	int mFallDistance;
+
+	// game is won or lost
+	bool mOver;
+
+	// landing row of focus block, only valid until it moves sideways or turns
+	int mLandingRow;
+	bool mLandingValid;
+};
+
+GameState::GameState():
+	mFocusBlock(NULL),mPreviewStart(0){
+	reset(0);
+}
+
+void GameState::reset(uint64_t seed) {
+	mPlayfield.clear();
+	mScore = 0;
+	mLevel = 1;
+	mLines = 0;
+	mGravity = getLevelGravity(mLevel);
+	mTicks = 0;
+	mFallDistance = 0;
+	mSlideTicks = 0;
+	mOver = false;
+	mSeed = seed;
+	mBag.reset(seed);
+
+	// create block, all blocks go back to pool at once
+	mBlockPool.reset();
+	mFocusBlock = createBlock(mBag.next());
+	for (int i = 0; i < PREVIEW_COUNT; i++) {
+		mPreview[i] = createBlock(mBag.next());
+	}
+	mPreviewStart = 0;
+	mBlockCount = 1;
+	mLandingValid = false;
+}
+
+void GameState::setBoardSize(int cols, int rows) {
+	mPlayfield.resize(cols, rows);
+}
+
+void GameState::setLevel(int level) {
+	mLevel = level < 1 ? 1 : (level > LEVEL_NUMS ? LEVEL_NUMS : level);
+	mGravity = getLevelGravity(mLevel);
+}
+
+Block* GameState::createBlock(BlockTypes type) {
+	Block* block = mBlockPool.acquire();
+	block->init(type, mPlayfield.getColumns());
+	return block;
+}
+
+int GameState::handleInput(GameInput input) {
+	if (mOver) {
+		return EVENT_NONE;
+	}
+
+	switch (input)
+	{
+	case INPUT_ROTATE:
+	{
+		int kick = checkRotationCollisions(mFocusBlock);
+		if (kick >= 0) {
+			mFocusBlock->move(mFocusBlock->getKickColumn(kick), mFocusBlock->getKickRow(kick));
+			mFocusBlock->rotate();
+			mLandingValid = false;
+			return EVENT_MOVED;
+		}
+		return EVENT_BLOCKED;
+	}
+	case INPUT_DOWN:
+		// moving down against bottom is not reported,
+		// landing row stays the same while falling
+		if (mFocusBlock->getRow() < getLandingRow()) {
+			mFocusBlock->move(DOWN);
+			return EVENT_MOVED;
+		}
+		return EVENT_NONE;
+	case INPUT_HARD_DROP:
+		// fall to landing row and lock at once
+		mFocusBlock->move(0, getLandingRow() - mFocusBlock->getRow());
+		mFallDistance = 0;
+		mSlideTicks = 0;
+		return EVENT_MOVED | handleBottomCollision();
+	case INPUT_LEFT:
+		if (!checkCollisions(mFocusBlock, LEFT)) {
+			mFocusBlock->move(LEFT);
+			mLandingValid = false;
+			return EVENT_MOVED;
+		}
+		return EVENT_BLOCKED;
+	case INPUT_RIGHT:
+		if (!checkCollisions(mFocusBlock, RIGHT)) {
+			mFocusBlock->move(RIGHT);
+			mLandingValid = false;
+			return EVENT_MOVED;
+		}
+		return EVENT_BLOCKED;
+	default:
+		break;
+	}
+	return EVENT_NONE;
+}
+
+int GameState::update() {
+	if (mOver) {
+		return EVENT_NONE;
+	}
+	mTicks++;
+
+	// block is on bottom when it reached its landing row
+	int fall = getLandingRow() - mFocusBlock->getRow();
+	mFallDistance += mGravity;
+	if (mFallDistance >= GRAVITY_ONE) {
+		if (fall > 0) {
+			// force to move down all squares of this tick at once,
+			// the landing row stops fast gravity without a collision test
+			int squares = mFallDistance / GRAVITY_ONE;
+			squares = squares < fall ? squares : fall;
+			mFocusBlock->move(0, squares);
+			fall -= squares;
+			// below 1G every square starts a new count, so slow levels
+			// keep their tick count per square
+			mFallDistance = mGravity < GRAVITY_ONE ? 0 : mFallDistance % GRAVITY_ONE;
+		} else {
+			// landed block keeps one square for next block
+			mFallDistance = GRAVITY_ONE;
+		}
+	}
+	bool landed = fall == 0;
+	// slide when focus block arrive bottom
+	if (landed) {
+		mSlideTicks++;
+	} else {
+		mSlideTicks = 0;
+	}
+	if (isElapsed(mSlideTicks, SLIDE_TIME)) {
+		mSlideTicks = 0;
+		return handleBottomCollision();
+	}
+	return EVENT_NONE;
+}
+
+Playfield* GameState::getPlayfield() {
+	return &mPlayfield;
+}
+
+Block* GameState::getFocusBlock() {
+	return mFocusBlock;
+}
+
+Block* GameState::getNextBlock(int index) {
+	return mPreview[(mPreviewStart + index) % PREVIEW_COUNT];
+}
+
+int GameState::getScore() {
+	return mScore;
+}
+
+int GameState::getLevel() {
+	return mLevel;
+}
+
+int GameState::getLines() {
+	return mLines;
+}
+
+int GameState::getTicks() {
+	return mTicks;
+}
+
+int GameState::getBlockCount() {
+	return mBlockCount;
+}
+
+uint64_t GameState::getSeed() {
+	return mSeed;
+}
+
+int GameState::getLandingRow() {
+	if (!mLandingValid) {
+		// every square falls to the first square below it in its column,
+		// four lookups instead of moving the block down row by row
+		BlockPose pose = mFocusBlock->getPose();
+		int distance = mPlayfield.getRows();
+		for (int i = 0; i < 4; i++) {
+			int fall = mPlayfield.getFloorRow(pose.col[i], pose.row[i]) - 1 - pose.row[i];
+			distance = fall < distance ? fall : distance;
+		}
+		mLandingRow = mFocusBlock->getRow() + distance;
+		mLandingValid = true;
+	}
+	return mLandingRow;
+}
+
+bool GameState::isOver() {
+	return mOver;
+}
+
+bool GameState::isElapsed(int ticks, int milliseconds) {
+	// compare without rounding tick duration
+	return (long long)ticks * 1000 >= (long long)milliseconds * FRAMES_PER_SECOND;
+}
+
+int GameState::getLevelGravity(int level) {
+	if (level < 1) {
+		return LEVEL_GRAVITY[0];
+	}
+	return LEVEL_GRAVITY[level > GRAVITY_LEVELS ? GRAVITY_LEVELS - 1 : level - 1];
+}
+
+int GameState::handleBottomCollision() {
+	int events = EVENT_LOCKED;
+	changeFoculBlock();
+
+	// get completed line number
+	int lineNums = checkCompletedLindes();
+	if (lineNums > 0) {
+		events |= EVENT_LINES_CLEARED;
+		// increase score by line number
+		mLines += lineNums;
+		mScore += lineNums*POINTS_PER_LINE;
+		// check whether if change level
+		if (mScore >= mLevel*POINTS_PER_LEVEL) {
+			mLevel++;
+			mGravity = getLevelGravity(mLevel);
+			if (checkWin()) {
+				return events | EVENT_WIN;
+			}
+		}
+	}
+	if (checkLoss()) {
+		events |= EVENT_LOSS;
+	}
+	return events;
+}
+
+void GameState::changeFoculBlock() {
+	BlockPose pose = mFocusBlock->getPose();
+	// lock squares into playfield, only metrics of their columns change
+	for (int i = 0; i < 4; i++) {
+		mPlayfield.setSquare(pose.col[i], pose.row[i], mFocusBlock->getType());
+	}
+	// change block, next blocks wait at start position
+	mBlockPool.release(mFocusBlock);
+	mFocusBlock = mPreview[mPreviewStart];
+
+	// create new last block in place of the old next block
+	mPreview[mPreviewStart] = createBlock(mBag.next());
+	mPreviewStart = (mPreviewStart + 1) % PREVIEW_COUNT;
+	mBlockCount++;
+	mLandingValid = false;
+}
+
+int GameState::checkCompletedLindes() {
+	int lineNums = mPlayfield.clearCompletedLines();
+	if (lineNums > 0) {
+		mLandingValid = false;
+	}
+	return lineNums;
+}
+
+bool GameState::checkWin() {
+	if (mLevel > LEVEL_NUMS) {
+		mOver = true;
+	}
+	return mOver;
+}
+
+bool GameState::checkLoss() {
+	// new block has no room
+	if (checkCollisions(mFocusBlock, DOWN)) {
+		mOver = true;
+	}
+	return mOver;
+}
+
+bool GameState::checkCollisions(BlockPose* pose, int cols, int rows) {
+	for (int i = 0; i < 4; i++) {
+		// check squares and walls with one cell lookup
+		if (mPlayfield.isBlocked(pose->col[i] + cols, pose->row[i] + rows)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GameState::checkCollisions(Block* block, Direction dir) {
+	BlockPose pose = block->getPose();
+	// get position after move on dir
+	switch (dir)
+	{
+	case LEFT:
+		return checkCollisions(&pose, -1, 0);
+	case RIGHT:
+		return checkCollisions(&pose, 1, 0);
+	case DOWN:
+		return checkCollisions(&pose, 0, 1);
+	default:
+		return checkCollisions(&pose, 0, 0);
+	}
+}
+
+int GameState::checkRotationCollisions(Block* block) {
+	// get positions after rotation
+	BlockPose pose = block->getRotatePosition();
+	// try kicks in order, every kick is four cell lookups
+	for (int i = 0; i < KICK_TESTS; i++) {
+		if (!checkCollisions(&pose, block->getKickColumn(i), block->getKickRow(i))) {
+			return i;
+		}
+	}
+	return -1;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////
+// ObjectPool.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+// fixed capacity pool, objects are stored inline and handed out
+// without heap allocation, released objects are reused first
+template <class T, int N>
+class ObjectPool
+{
+public:
+	// constructor
+	ObjectPool();
+
+	// get an unused object, NULL when all objects are used
+	T* acquire();
+
+	// give object back to pool
+	void release(T* object);
+
+	// give all objects back to pool
+	void reset();
+
+	// get number of objects in use
+	int getUsedCount();
+
+private:
+	// storage for objects
+	T mObjects[N];
+	// indices of released objects
+	int mFreeList[N];
+	int mFreeCount;
+	// objects never handed out start from here
+	int mNextUnused;
+};
+
+template <class T, int N>
+ObjectPool<T, N>::ObjectPool():
+	mFreeCount(0),mNextUnused(0){
+}
+
+template <class T, int N>
+T* ObjectPool<T, N>::acquire() {
+	// reuse released object first
+	if (mFreeCount > 0) {
+		mFreeCount--;
+		return &mObjects[mFreeList[mFreeCount]];
+	}
+	if (mNextUnused < N) {
+		return &mObjects[mNextUnused++];
+	}
+	return NULL;
+}
+
+template <class T, int N>
+void ObjectPool<T, N>::release(T* object) {
+	if (object == NULL) {
+		return;
+	}
+	mFreeList[mFreeCount] = (int)(object - mObjects);
+	mFreeCount++;
+}
+
+template <class T, int N>
+void ObjectPool<T, N>::reset() {
+	// constant time, the free list is rebuilt as objects are released
+	mFreeCount = 0;
+	mNextUnused = 0;
+}
+
+template <class T, int N>
+int ObjectPool<T, N>::getUsedCount() {
+	return mNextUnused - mFreeCount;
+}
\ No newline at end of file
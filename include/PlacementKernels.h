@@ -0,0 +1,393 @@
+//////////////////////////////////////////////////////////////////////////
+// PlacementKernels.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/Enums.h"
+#include "../include/Block.h"
+#include "../include/Playfield.h"
+
+// vector kernels are only built for x86, other targets use the scalar one
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PLACEMENT_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// msvc accepts every intrinsic without target flags
+#define KERNEL_TARGET(name)
+#else
+// gcc and clang build one function for a newer instruction set
+#define KERNEL_TARGET(name) __attribute__((target(name)))
+#endif
+#endif
+
+// columns tested in one call, one 16 bit lane each
+const int KERNEL_LANES = 16;
+// a board is tested in windows of 16 columns, a block is up to 4 columns
+// wide, so a window holds the block in its first 13 lanes and the next
+// window starts 13 columns further right
+const int KERNEL_WINDOW_LANES = KERNEL_LANES - 3;
+const int KERNEL_WINDOWS = (MAX_BOARD_COLUMNS + KERNEL_WINDOW_LANES - 1) / KERNEL_WINDOW_LANES;
+// the last window stores all its lanes past the end of the board
+const int LANDING_BATCH_LANES = KERNEL_WINDOW_LANES * (KERNEL_WINDOWS - 1) + KERNEL_LANES;
+// empty rows above and blocked rows below playfield, so kernels
+// never test row bounds
+const int KERNEL_TOP_ROWS = 4;
+const int KERNEL_BOTTOM_ROWS = 4;
+const int KERNEL_BOARD_ROWS = KERNEL_TOP_ROWS + MAX_BOARD_ROWS + KERNEL_BOTTOM_ROWS;
+// landing row of a column where the block does not fit at its start row
+const int LANDING_BLOCKED = -128;
+
+static_assert(SQUARES_PER_ROW <= KERNEL_WINDOW_LANES, "default board fits in one window");
+
+// 16 columns of every row of playfield with padding rows, one set of
+// rows for every window
+struct KernelBoard {
+	int columnCount;
+	int windowCount;
+	// squares of window, columns right of the walls are set
+	uint16_t rows[KERNEL_WINDOWS][KERNEL_BOARD_ROWS];
+	// same where the row is full outside the window, else 0, so a block
+	// completes the line when it fills the rest of the window
+	uint16_t fills[KERNEL_WINDOWS][KERNEL_BOARD_ROWS];
+};
+
+// landing of one block rotation in every column
+struct LandingBatch {
+	// column of bounding box in first entry, every entry is one column right
+	int firstCol;
+	int count;
+	// row of bounding box where block comes to rest, or LANDING_BLOCKED
+	int16_t rows[LANDING_BATCH_LANES];
+	// bit n is set when row n of bounding box completes a line
+	uint16_t cleared[LANDING_BATCH_LANES];
+};
+
+// masks of bounding box rows moved to every lane of a window, lane n
+// holds the block with its leftmost square in window column n
+struct LaneMaskTable {
+	uint16_t masks[BLOCK_TOTAL][4][4][KERNEL_LANES];
+	// 0xFFFF for the first n lanes
+	uint16_t valid[KERNEL_LANES + 1][KERNEL_LANES];
+	int firstCol[BLOCK_TOTAL][4];
+	// columns between leftmost and rightmost square
+	int span[BLOCK_TOTAL][4];
+};
+
+constexpr LaneMaskTable makeLaneMaskTable() {
+	LaneMaskTable table = {};
+	for (int type = 0; type < BLOCK_TOTAL; type++) {
+		for (int rotation = 0; rotation < 4; rotation++) {
+			int first = -BLOCK_MASKS.left[type][rotation];
+			table.firstCol[type][rotation] = first;
+			table.span[type][rotation] = BLOCK_MASKS.right[type][rotation] - BLOCK_MASKS.left[type][rotation];
+			for (int lane = 0; lane < KERNEL_WINDOW_LANES; lane++) {
+				int col = first + lane;
+				for (int boxRow = 0; boxRow < 4; boxRow++) {
+					uint16_t mask = BLOCK_MASKS.rows[type][rotation][boxRow];
+					table.masks[type][rotation][boxRow][lane] = (uint16_t)(col >= 0 ? mask << col : mask >> -col);
+				}
+			}
+		}
+	}
+	for (int count = 0; count <= KERNEL_LANES; count++) {
+		for (int lane = 0; lane < count; lane++) {
+			table.valid[count][lane] = 0xFFFF;
+		}
+	}
+	return table;
+}
+
+constexpr LaneMaskTable LANE_MASKS = makeLaneMaskTable();
+
+static_assert(LANE_MASKS.span[STRAIGHT_BLOCK][0] == 3 && LANE_MASKS.span[STRAIGHT_BLOCK][1] == 0,
+	"straight block fits in every column when standing");
+
+// finds where a block lands in every column with one call, vector
+// versions test all columns together, the best one the cpu supports
+// is chosen at runtime
+class PlacementKernels
+{
+public:
+	// copy row masks of a board of any size into padded windows
+	static void loadBoard(const uint64_t* rows, int columnCount, int rowCount, KernelBoard* board);
+
+	// drop block rotation from start row in every column
+	static void findLandings(KernelBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch);
+
+	// same with a chosen instruction set
+	static void findLandings(KernelLevel level, KernelBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch);
+
+	// best instruction set of this cpu
+	static KernelLevel getSupportedLevel();
+
+	// instruction set used by findLandings, lowered to supported level
+	static KernelLevel getLevel();
+	static void setLevel(KernelLevel level);
+
+	static const char* getLevelName(KernelLevel level);
+
+private:
+	// fill the batch entries of one window
+	static void findLandingsScalar(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch);
+#ifdef PLACEMENT_KERNELS_X86
+	static void findLandingsSse2(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch);
+	static void findLandingsAvx2(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch);
+#endif
+
+	// ask cpu and os once
+	static KernelLevel detectLevel();
+
+	static KernelLevel sSupportedLevel;
+	static KernelLevel sLevel;
+};
+
+// init static levels
+KernelLevel PlacementKernels::sSupportedLevel = PlacementKernels::detectLevel();
+KernelLevel PlacementKernels::sLevel = PlacementKernels::sSupportedLevel;
+
+void PlacementKernels::loadBoard(const uint64_t* rows, int columnCount, int rowCount, KernelBoard* board) {
+	board->columnCount = columnCount;
+	board->windowCount = (columnCount + KERNEL_WINDOW_LANES - 1) / KERNEL_WINDOW_LANES;
+	uint64_t fullRowMask = columnCount == 64 ? ~0ULL : (1ULL << columnCount) - 1;
+	for (int window = 0; window < board->windowCount; window++) {
+		int base = window * KERNEL_WINDOW_LANES;
+		uint64_t windowMask = 0xFFFFULL << base;
+		// columns right of the walls, window bits past bit 63 count too
+		uint16_t walls = (uint16_t)~(fullRowMask >> base);
+		uint16_t* windowRows = board->rows[window];
+		uint16_t* fills = board->fills[window];
+		memset(windowRows, 0, KERNEL_TOP_ROWS * sizeof(uint16_t));
+		memset(fills, 0, KERNEL_TOP_ROWS * sizeof(uint16_t));
+		for (int row = 0; row < rowCount; row++) {
+			uint16_t squares = (uint16_t)(rows[row] >> base) | walls;
+			windowRows[KERNEL_TOP_ROWS + row] = squares;
+			fills[KERNEL_TOP_ROWS + row] = ((rows[row] | windowMask) & fullRowMask) == fullRowMask ? squares : 0;
+		}
+		// all bits set, so every lane stops, and no line completes there
+		memset(windowRows + KERNEL_TOP_ROWS + rowCount, 0xFF, KERNEL_BOTTOM_ROWS * sizeof(uint16_t));
+		memset(fills + KERNEL_TOP_ROWS + rowCount, 0, KERNEL_BOTTOM_ROWS * sizeof(uint16_t));
+	}
+}
+
+void PlacementKernels::findLandings(KernelBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	findLandings(sLevel, board, type, rotation, row, batch);
+}
+
+void PlacementKernels::findLandings(KernelLevel level, KernelBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	batch->firstCol = LANE_MASKS.firstCol[type][rotation];
+	batch->count = board->columnCount - LANE_MASKS.span[type][rotation];
+	// rows above playfield are empty, a block higher up falls the same way
+	if (row < -KERNEL_TOP_ROWS) {
+		row = -KERNEL_TOP_ROWS;
+	}
+	// windows left to right, a window may overwrite the first entries of
+	// the next one with lanes it does not test
+	for (int window = 0; window * KERNEL_WINDOW_LANES < batch->count; window++) {
+		switch (level)
+		{
+#ifdef PLACEMENT_KERNELS_X86
+		case KERNEL_AVX2:
+			findLandingsAvx2(board, window, type, rotation, row, batch);
+			break;
+		case KERNEL_SSE2:
+			findLandingsSse2(board, window, type, rotation, row, batch);
+			break;
+#endif
+		default:
+			findLandingsScalar(board, window, type, rotation, row, batch);
+			break;
+		}
+	}
+}
+
+KernelLevel PlacementKernels::getSupportedLevel() {
+	return sSupportedLevel;
+}
+
+KernelLevel PlacementKernels::getLevel() {
+	return sLevel;
+}
+
+void PlacementKernels::setLevel(KernelLevel level) {
+	sLevel = level < sSupportedLevel ? level : sSupportedLevel;
+}
+
+const char* PlacementKernels::getLevelName(KernelLevel level) {
+	switch (level)
+	{
+	case KERNEL_SSE2:
+		return "sse2";
+	case KERNEL_AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+void PlacementKernels::findLandingsScalar(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	const uint16_t* rows = board->rows[window] + KERNEL_TOP_ROWS;
+	const uint16_t* fills = board->fills[window] + KERNEL_TOP_ROWS;
+	int base = window * KERNEL_WINDOW_LANES;
+	int lanes = batch->count - base < KERNEL_WINDOW_LANES ? batch->count - base : KERNEL_WINDOW_LANES;
+	for (int lane = 0; lane < lanes; lane++) {
+		uint16_t masks[4];
+		for (int boxRow = 0; boxRow < 4; boxRow++) {
+			masks[boxRow] = LANE_MASKS.masks[type][rotation][boxRow][lane];
+		}
+		int landing = LANDING_BLOCKED;
+		for (int test = row; ; test++) {
+			bool colliding = false;
+			for (int boxRow = 0; boxRow < 4; boxRow++) {
+				colliding |= (rows[test + boxRow] & masks[boxRow]) != 0;
+			}
+			if (colliding) {
+				break;
+			}
+			landing = test;
+		}
+		uint16_t cleared = 0;
+		if (landing != LANDING_BLOCKED) {
+			for (int boxRow = 0; boxRow < 4; boxRow++) {
+				if ((fills[landing + boxRow] | masks[boxRow]) == 0xFFFF) {
+					cleared |= 1 << boxRow;
+				}
+			}
+		}
+		batch->rows[base + lane] = (int16_t)landing;
+		batch->cleared[base + lane] = cleared;
+	}
+}
+
+#ifdef PLACEMENT_KERNELS_X86
+
+// every lane drops until the next row collides, the loop ends when the
+// last lane has come to rest, the padding rows stop every lane
+
+KERNEL_TARGET("sse2")
+void PlacementKernels::findLandingsSse2(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	const uint16_t* rows = board->rows[window] + KERNEL_TOP_ROWS;
+	const uint16_t* fills = board->fills[window] + KERNEL_TOP_ROWS;
+	int base = window * KERNEL_WINDOW_LANES;
+	int lanes = batch->count - base < KERNEL_WINDOW_LANES ? batch->count - base : KERNEL_WINDOW_LANES;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16((short)0xFFFF);
+	// eight lanes in a register, two passes cover a window
+	for (int group = 0; group < lanes; group += 8) {
+		__m128i masks[4];
+		for (int boxRow = 0; boxRow < 4; boxRow++) {
+			masks[boxRow] = _mm_loadu_si128((const __m128i*)&LANE_MASKS.masks[type][rotation][boxRow][group]);
+		}
+		__m128i valid = _mm_loadu_si128((const __m128i*)&LANE_MASKS.valid[lanes][group]);
+
+		// lanes that fit at start row
+		__m128i hits = zero;
+		for (int boxRow = 0; boxRow < 4; boxRow++) {
+			hits = _mm_or_si128(hits, _mm_and_si128(_mm_set1_epi16((short)rows[row + boxRow]), masks[boxRow]));
+		}
+		__m128i falling = _mm_and_si128(valid, _mm_cmpeq_epi16(hits, zero));
+		__m128i landing = _mm_set1_epi16((short)LANDING_BLOCKED);
+		__m128i cleared = zero;
+
+		for (int test = row; _mm_movemask_epi8(falling) != 0; test++) {
+			hits = zero;
+			for (int boxRow = 0; boxRow < 4; boxRow++) {
+				hits = _mm_or_si128(hits, _mm_and_si128(_mm_set1_epi16((short)rows[test + 1 + boxRow]), masks[boxRow]));
+			}
+			// falling lanes where next row collides rest at this row
+			__m128i resting = _mm_andnot_si128(_mm_cmpeq_epi16(hits, zero), falling);
+			if (_mm_movemask_epi8(resting) != 0) {
+				__m128i lines = zero;
+				for (int boxRow = 0; boxRow < 4; boxRow++) {
+					__m128i filled = _mm_or_si128(_mm_set1_epi16((short)fills[test + boxRow]), masks[boxRow]);
+					lines = _mm_or_si128(lines, _mm_and_si128(_mm_cmpeq_epi16(filled, full), _mm_set1_epi16((short)(1 << boxRow))));
+				}
+				landing = _mm_or_si128(_mm_andnot_si128(resting, landing), _mm_and_si128(resting, _mm_set1_epi16((short)test)));
+				cleared = _mm_or_si128(cleared, _mm_and_si128(resting, lines));
+				falling = _mm_andnot_si128(resting, falling);
+			}
+		}
+		_mm_storeu_si128((__m128i*)&batch->rows[base + group], landing);
+		_mm_storeu_si128((__m128i*)&batch->cleared[base + group], cleared);
+	}
+}
+
+KERNEL_TARGET("avx2")
+void PlacementKernels::findLandingsAvx2(KernelBoard* board, int window, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	const uint16_t* rows = board->rows[window] + KERNEL_TOP_ROWS;
+	const uint16_t* fills = board->fills[window] + KERNEL_TOP_ROWS;
+	int base = window * KERNEL_WINDOW_LANES;
+	int lanes = batch->count - base < KERNEL_WINDOW_LANES ? batch->count - base : KERNEL_WINDOW_LANES;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16((short)0xFFFF);
+	// sixteen lanes in a register, one pass covers a window
+	__m256i masks[4];
+	for (int boxRow = 0; boxRow < 4; boxRow++) {
+		masks[boxRow] = _mm256_loadu_si256((const __m256i*)LANE_MASKS.masks[type][rotation][boxRow]);
+	}
+	__m256i valid = _mm256_loadu_si256((const __m256i*)LANE_MASKS.valid[lanes]);
+
+	// lanes that fit at start row
+	__m256i hits = zero;
+	for (int boxRow = 0; boxRow < 4; boxRow++) {
+		hits = _mm256_or_si256(hits, _mm256_and_si256(_mm256_set1_epi16((short)rows[row + boxRow]), masks[boxRow]));
+	}
+	__m256i falling = _mm256_and_si256(valid, _mm256_cmpeq_epi16(hits, zero));
+	__m256i landing = _mm256_set1_epi16((short)LANDING_BLOCKED);
+	__m256i cleared = zero;
+
+	for (int test = row; !_mm256_testz_si256(falling, falling); test++) {
+		hits = zero;
+		for (int boxRow = 0; boxRow < 4; boxRow++) {
+			hits = _mm256_or_si256(hits, _mm256_and_si256(_mm256_set1_epi16((short)rows[test + 1 + boxRow]), masks[boxRow]));
+		}
+		// falling lanes where next row collides rest at this row
+		__m256i resting = _mm256_andnot_si256(_mm256_cmpeq_epi16(hits, zero), falling);
+		if (!_mm256_testz_si256(resting, resting)) {
+			__m256i lines = zero;
+			for (int boxRow = 0; boxRow < 4; boxRow++) {
+				__m256i filled = _mm256_or_si256(_mm256_set1_epi16((short)fills[test + boxRow]), masks[boxRow]);
+				lines = _mm256_or_si256(lines, _mm256_and_si256(_mm256_cmpeq_epi16(filled, full), _mm256_set1_epi16((short)(1 << boxRow))));
+			}
+			landing = _mm256_blendv_epi8(landing, _mm256_set1_epi16((short)test), resting);
+			cleared = _mm256_or_si256(cleared, _mm256_and_si256(resting, lines));
+			falling = _mm256_andnot_si256(resting, falling);
+		}
+	}
+	_mm256_storeu_si256((__m256i*)&batch->rows[base], landing);
+	_mm256_storeu_si256((__m256i*)&batch->cleared[base], cleared);
+}
+
+#endif
+
+KernelLevel PlacementKernels::detectLevel() {
+#if defined(PLACEMENT_KERNELS_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	// avx needs os support for saving the wide registers
+	bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	bool avx2 = false;
+	if (avx && maxLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return avx2 ? KERNEL_AVX2 : (sse2 ? KERNEL_SSE2 : KERNEL_SCALAR);
+#elif defined(PLACEMENT_KERNELS_X86)
+	// also checks os support of avx registers
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return KERNEL_AVX2;
+	}
+	return __builtin_cpu_supports("sse2") ? KERNEL_SSE2 : KERNEL_SCALAR;
+#else
+	return KERNEL_SCALAR;
+#endif
+}
\ No newline at end of file
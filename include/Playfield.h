@@ -0,0 +1,429 @@
+//////////////////////////////////////////////////////////////////////////
+// Playfield.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/Enums.h"
+
+// mask of a row of the default board with all squares, for search boards
+const uint16_t FULL_ROW_MASK = (1 << SQUARES_PER_ROW) - 1;
+// words of a bitset with one bit for every row
+const int ROW_WORDS = MAX_BOARD_ROWS / 64;
+
+static_assert(MAX_BOARD_ROWS % 64 == 0, "row bitsets are whole words");
+static_assert(MAX_BOARD_COLUMNS <= 64, "a row is one word");
+
+// class for the locked squares of game area
+// every row is a bitmask (bit n is set when column n is occupied),
+// a parallel array keeps block type of every square for drawing,
+// column bitsets and metrics are kept up to date on every change,
+// storage is sized for the largest board so resizing never allocates
+class Playfield
+{
+public:
+	// constructor
+	Playfield(int cols = SQUARES_PER_ROW, int rows = PLAYFIELD_ROWS);
+
+	// change board size, clamped to board limits, removes all squares
+	void resize(int cols, int rows);
+
+	// remove all squares
+	void clear();
+
+	// check if a cell holds a square, cells out of playfield are empty
+	bool isOccupied(int col, int row);
+
+	// check if a square can not be placed at a cell,
+	// cells beside the walls and below the bottom are blocked,
+	// cells above the playfield are free
+	bool isBlocked(int col, int row);
+
+	// add a square into playfield, squares out of playfield are dropped
+	void setSquare(int col, int row, BlockTypes type);
+
+	// getter
+	BlockTypes getSquare(int col, int row);
+	uint64_t getRowMask(int row);
+	int getColumns();
+	int getRows();
+
+	// delete completed lines and move the lines above down,
+	// works in place in one pass, return number of deleted lines
+	int clearCompletedLines();
+
+	// rows changed since dirty rows were last cleared
+	bool hasDirtyRows();
+	bool isDirtyRow(int row);
+	void clearDirtyRows();
+
+	// get number of rows from bottom up to top square of a column
+	int getColumnHeight(int col);
+	// get empty cells below top square of a column
+	int getColumnHoles(int col);
+	// get depth of a column below its lower neighbour, walls are full height
+	int getWellDepth(int col);
+	// get number of squares in a row
+	int getRowFill(int row);
+	// get first occupied row below a cell, number of rows when there is none
+	int getFloorRow(int col, int row);
+	// get height of highest column
+	int getMaxHeight();
+	// get empty cells below top squares of all columns
+	int getHoleCount();
+
+	// get number of set bits
+	static int countBits(uint64_t mask);
+	// get index of lowest set bit, mask must not be 0
+	static int getLowestBit(uint64_t mask);
+
+	// convert between square center pixel and cell, squares shrink
+	// so every board fits the game area
+	int getSquareSize();
+	int columnFromX(int x);
+	int rowFromY(int y);
+	int xFromColumn(int col);
+	int yFromRow(int row);
+
+private:
+	// recount metrics of a column from its bitset, and wells beside it
+	void updateColumn(int col);
+	void updateWells(int col);
+	void updateWell(int col);
+
+	// board size
+	int mColumnCount;
+	int mRowCount;
+	// words used in row bitsets
+	int mRowWords;
+	uint64_t mFullRowMask;
+
+	// pixel size of a square and top left corner of playfield
+	int mSquareSize;
+	int mLeft;
+	int mTop;
+
+	// occupied columns of every row
+	uint64_t mRows[MAX_BOARD_ROWS];
+	// block type of every square, only valid for occupied cells
+	uint8_t mCells[MAX_BOARD_ROWS][MAX_BOARD_COLUMNS];
+	// bit n is set when row n has changed
+	uint64_t mDirtyRows[ROW_WORDS];
+	// rows that got squares since completed lines were last deleted,
+	// only these rows can be completed
+	uint64_t mFilledRows[ROW_WORDS];
+
+	// occupied rows of every column
+	uint64_t mColumns[MAX_BOARD_COLUMNS][ROW_WORDS];
+	// metrics of every column and row
+	uint16_t mHeights[MAX_BOARD_COLUMNS];
+	uint16_t mSquares[MAX_BOARD_COLUMNS];
+	uint16_t mHoles[MAX_BOARD_COLUMNS];
+	uint16_t mWells[MAX_BOARD_COLUMNS];
+	uint8_t mRowFills[MAX_BOARD_ROWS];
+};
+
+Playfield::Playfield(int cols, int rows)
+{
+	resize(cols, rows);
+}
+
+void Playfield::resize(int cols, int rows) {
+	mColumnCount = cols < MIN_BOARD_COLUMNS ? MIN_BOARD_COLUMNS : (cols > MAX_BOARD_COLUMNS ? MAX_BOARD_COLUMNS : cols);
+	mRowCount = rows < MIN_BOARD_ROWS ? MIN_BOARD_ROWS : (rows > MAX_BOARD_ROWS ? MAX_BOARD_ROWS : rows);
+	mRowWords = (mRowCount + 63) / 64;
+	mFullRowMask = mColumnCount == 64 ? ~0ULL : (1ULL << mColumnCount) - 1;
+
+	// largest square that fits visible rows and columns into game area,
+	// hidden rows sit above it
+	int width = (GAME_AREA_RIGHT - GAME_AREA_LEFT) / mColumnCount;
+	int height = (GAME_AREA_BOTTOM - GAME_AREA_TOP) / (mRowCount - PLAYFIELD_HIDDEN_ROWS);
+	mSquareSize = width < height ? width : height;
+	mSquareSize = mSquareSize > 0 ? mSquareSize : 1;
+	mLeft = GAME_AREA_LEFT + (GAME_AREA_RIGHT - GAME_AREA_LEFT - mColumnCount * mSquareSize) / 2;
+	mTop = GAME_AREA_BOTTOM - mRowCount * mSquareSize;
+	clear();
+}
+
+void Playfield::clear() {
+	memset(mRows, 0, mRowCount * sizeof(mRows[0]));
+	memset(mColumns, 0, mColumnCount * sizeof(mColumns[0]));
+	memset(mHeights, 0, sizeof(mHeights));
+	memset(mSquares, 0, sizeof(mSquares));
+	memset(mHoles, 0, sizeof(mHoles));
+	memset(mRowFills, 0, sizeof(mRowFills));
+	memset(mFilledRows, 0, sizeof(mFilledRows));
+	for (int col = 0; col < mColumnCount; col++) {
+		updateWell(col);
+	}
+	// every row is drawn again
+	memset(mDirtyRows, 0, sizeof(mDirtyRows));
+	for (int row = 0; row < mRowCount; row++) {
+		mDirtyRows[row >> 6] |= 1ULL << (row & 63);
+	}
+}
+
+bool Playfield::isOccupied(int col, int row) {
+	if (col < 0 || col >= mColumnCount || row < 0 || row >= mRowCount) {
+		return false;
+	}
+	return (mRows[row] >> col) & 1;
+}
+
+bool Playfield::isBlocked(int col, int row) {
+	if (col < 0 || col >= mColumnCount || row >= mRowCount) {
+		return true;
+	}
+	if (row < 0) {
+		return false;
+	}
+	return (mRows[row] >> col) & 1;
+}
+
+void Playfield::setSquare(int col, int row, BlockTypes type) {
+	if (col < 0 || col >= mColumnCount || row < 0 || row >= mRowCount) {
+		return;
+	}
+	mCells[row][col] = (uint8_t)type;
+	mDirtyRows[row >> 6] |= 1ULL << (row & 63);
+	if ((mRows[row] >> col) & 1) {
+		return;
+	}
+	mRows[row] |= 1ULL << col;
+	mColumns[col][row >> 6] |= 1ULL << (row & 63);
+	mRowFills[row]++;
+	mFilledRows[row >> 6] |= 1ULL << (row & 63);
+
+	// only this column and its neighbours change
+	if (mRowCount - row > mHeights[col]) {
+		mHeights[col] = (uint16_t)(mRowCount - row);
+	}
+	mSquares[col]++;
+	mHoles[col] = (uint16_t)(mHeights[col] - mSquares[col]);
+	updateWells(col);
+}
+
+BlockTypes Playfield::getSquare(int col, int row) {
+	return (BlockTypes)mCells[row][col];
+}
+
+uint64_t Playfield::getRowMask(int row) {
+	return mRows[row];
+}
+
+int Playfield::getColumns() {
+	return mColumnCount;
+}
+
+int Playfield::getRows() {
+	return mRowCount;
+}
+
+int Playfield::clearCompletedLines() {
+	// only rows filled since last time can be completed
+	uint64_t completed[ROW_WORDS] = {};
+	int lineNums = 0;
+	int lowest = -1;
+	for (int word = 0; word < mRowWords; word++) {
+		for (uint64_t rows = mFilledRows[word]; rows != 0; rows &= rows - 1) {
+			int row = word * 64 + getLowestBit(rows);
+			if (mRowFills[row] == mColumnCount) {
+				completed[word] |= 1ULL << (row & 63);
+				lineNums++;
+				lowest = row > lowest ? row : lowest;
+			}
+		}
+		mFilledRows[word] = 0;
+	}
+	if (lineNums == 0) {
+		return 0;
+	}
+
+	// move remaining rows down in one sweep, from lowest completed line
+	// up so no row is overwritten before it is moved
+	int target = lowest;
+	for (int row = lowest; row >= 0; row--) {
+		if ((completed[row >> 6] >> (row & 63)) & 1) {
+			continue;
+		}
+		if (target != row) {
+			mRows[target] = mRows[row];
+			mRowFills[target] = mRowFills[row];
+			if (mRows[row] != 0) {
+				memcpy(mCells[target], mCells[row], mColumnCount);
+			}
+		}
+		target--;
+	}
+	// top rows are empty now
+	for (int row = target; row >= 0; row--) {
+		mRows[row] = 0;
+		mRowFills[row] = 0;
+	}
+
+	// rows down to the lowest completed line change, rebuild them in
+	// column bitsets from set bits of their row masks
+	for (int row = 0; row <= lowest; row++) {
+		mDirtyRows[row >> 6] |= 1ULL << (row & 63);
+	}
+	for (int col = 0; col < mColumnCount; col++) {
+		for (int word = 0; word <= (lowest >> 6); word++) {
+			int bits = lowest - word * 64 + 1;
+			mColumns[col][word] &= bits >= 64 ? 0 : ~0ULL << bits;
+		}
+	}
+	for (int row = 0; row <= lowest; row++) {
+		for (uint64_t cols = mRows[row]; cols != 0; cols &= cols - 1) {
+			mColumns[getLowestBit(cols)][row >> 6] |= 1ULL << (row & 63);
+		}
+	}
+	// completed lines cross every column
+	for (int col = 0; col < mColumnCount; col++) {
+		updateColumn(col);
+	}
+	for (int col = 0; col < mColumnCount; col++) {
+		updateWell(col);
+	}
+	return lineNums;
+}
+
+bool Playfield::hasDirtyRows() {
+	for (int word = 0; word < mRowWords; word++) {
+		if (mDirtyRows[word] != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Playfield::isDirtyRow(int row) {
+	return (mDirtyRows[row >> 6] >> (row & 63)) & 1;
+}
+
+void Playfield::clearDirtyRows() {
+	memset(mDirtyRows, 0, sizeof(mDirtyRows));
+}
+
+int Playfield::getColumnHeight(int col) {
+	return mHeights[col];
+}
+
+int Playfield::getColumnHoles(int col) {
+	return mHoles[col];
+}
+
+int Playfield::getWellDepth(int col) {
+	return mWells[col];
+}
+
+int Playfield::getRowFill(int row) {
+	return mRowFills[row];
+}
+
+int Playfield::getFloorRow(int col, int row) {
+	// above top square the height is enough
+	int top = mRowCount - mHeights[col];
+	if (row < top) {
+		return top;
+	}
+	// under an overhang, lowest set bit of the rows below
+	int next = row + 1;
+	for (int word = next >> 6; word < mRowWords; word++) {
+		uint64_t below = mColumns[col][word];
+		if (word == next >> 6) {
+			below &= ~0ULL << (next & 63);
+		}
+		if (below != 0) {
+			return word * 64 + getLowestBit(below);
+		}
+	}
+	return mRowCount;
+}
+
+int Playfield::getMaxHeight() {
+	int height = 0;
+	for (int col = 0; col < mColumnCount; col++) {
+		height = mHeights[col] > height ? mHeights[col] : height;
+	}
+	return height;
+}
+
+int Playfield::getHoleCount() {
+	int holes = 0;
+	for (int col = 0; col < mColumnCount; col++) {
+		holes += mHoles[col];
+	}
+	return holes;
+}
+
+int Playfield::countBits(uint64_t mask) {
+	// add bits in pairs, then nibbles, then bytes
+	mask = mask - ((mask >> 1) & 0x5555555555555555ULL);
+	mask = (mask & 0x3333333333333333ULL) + ((mask >> 2) & 0x3333333333333333ULL);
+	mask = (mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((mask * 0x0101010101010101ULL) >> 56);
+}
+
+int Playfield::getLowestBit(uint64_t mask) {
+	// bits below lowest set bit
+	return countBits((mask & (0 - mask)) - 1);
+}
+
+void Playfield::updateColumn(int col) {
+	// lowest set bit is top square
+	int top = mRowCount;
+	int squares = 0;
+	for (int word = 0; word < mRowWords; word++) {
+		uint64_t mask = mColumns[col][word];
+		if (mask != 0 && top == mRowCount) {
+			top = word * 64 + getLowestBit(mask);
+		}
+		squares += countBits(mask);
+	}
+	mHeights[col] = (uint16_t)(mRowCount - top);
+	mSquares[col] = (uint16_t)squares;
+	mHoles[col] = (uint16_t)(mHeights[col] - squares);
+}
+
+void Playfield::updateWells(int col) {
+	for (int well = col - 1; well <= col + 1; well++) {
+		if (well >= 0 && well < mColumnCount) {
+			updateWell(well);
+		}
+	}
+}
+
+void Playfield::updateWell(int col) {
+	int left = col > 0 ? mHeights[col - 1] : mRowCount;
+	int right = col < mColumnCount - 1 ? mHeights[col + 1] : mRowCount;
+	int depth = (left < right ? left : right) - mHeights[col];
+	mWells[col] = (uint16_t)(depth > 0 ? depth : 0);
+}
+
+int Playfield::getSquareSize() {
+	return mSquareSize;
+}
+
+int Playfield::columnFromX(int x) {
+	return (x - mLeft) / mSquareSize;
+}
+
+int Playfield::rowFromY(int y) {
+	// squares above playfield
+	if (y < mTop) {
+		return -1;
+	}
+	return (y - mTop) / mSquareSize;
+}
+
+int Playfield::xFromColumn(int col) {
+	return mLeft + col * mSquareSize + mSquareSize / 2;
+}
+
+int Playfield::yFromRow(int row) {
+	return mTop + row * mSquareSize + mSquareSize / 2;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////////
+// Random.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "../include/Enums.h"
+
+// PCG32 random number generator, every game owns its own state,
+// so the same seed always gives the same numbers
+class Random
+{
+public:
+	// constructor
+	Random();
+	Random(uint64_t seed);
+
+	// restart sequence from seed
+	void seed(uint64_t seed);
+
+	// get next 32 bit number
+	uint32_t next();
+
+	// get number in [0, bound) without modulo bias
+	uint32_t nextInt(uint32_t bound);
+
+private:
+	uint64_t mState;
+	uint64_t mIncrement;
+};
+
+Random::Random()
+{
+	seed(0);
+}
+
+Random::Random(uint64_t seed) {
+	this->seed(seed);
+}
+
+void Random::seed(uint64_t seed) {
+	// same seeding as the reference implementation, stream is fixed
+	mState = 0;
+	mIncrement = (0xda3e39cb94b95bdbULL << 1) | 1;
+	next();
+	mState += seed;
+	next();
+}
+
+uint32_t Random::next() {
+	uint64_t state = mState;
+	mState = state * 6364136223846793005ULL + mIncrement;
+	uint32_t xorShifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+	uint32_t rotation = (uint32_t)(state >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+
+uint32_t Random::nextInt(uint32_t bound) {
+	// reject the low numbers that would make some results more likely
+	uint32_t threshold = (0u - bound) % bound;
+	for (;;) {
+		uint32_t number = next();
+		if (number >= threshold) {
+			return number % bound;
+		}
+	}
+}
+
+// 7-bag randomizer, every block type comes once in each
+// shuffled bag of seven, so droughts are short
+class BlockBag
+{
+public:
+	// constructor
+	BlockBag();
+
+	// restart from seed with an empty bag
+	void reset(uint64_t seed);
+
+	// get next block type
+	BlockTypes next();
+
+private:
+	// refill and shuffle bag
+	void fill();
+
+	Random mRandom;
+	BlockTypes mBag[BLOCK_TOTAL];
+	// number of types taken from bag
+	int mTaken;
+};
+
+BlockBag::BlockBag()
+{
+	reset(0);
+}
+
+void BlockBag::reset(uint64_t seed) {
+	mRandom.seed(seed);
+	mTaken = BLOCK_TOTAL;
+}
+
+BlockTypes BlockBag::next() {
+	if (mTaken == BLOCK_TOTAL) {
+		fill();
+	}
+	return mBag[mTaken++];
+}
+
+void BlockBag::fill() {
+	for (int i = 0; i < BLOCK_TOTAL; i++) {
+		mBag[i] = (BlockTypes)i;
+	}
+	// Fisher-Yates shuffle
+	for (int i = BLOCK_TOTAL - 1; i > 0; i--) {
+		int j = (int)mRandom.nextInt(i + 1);
+		BlockTypes type = mBag[i];
+		mBag[i] = mBag[j];
+		mBag[j] = type;
+	}
+	mTaken = 0;
+}
\ No newline at end of file
@@ -0,0 +1,413 @@
+//////////////////////////////////////////////////////////////////////////
+// Replay.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../include/Enums.h"
+#include "../include/GameState.h"
+
+// replay file layout, integers are little endian:
+//   magic "FBRP", version byte, seed (8 bytes)
+//   board columns (1 byte) and rows (2 bytes), version 1 has no board
+//   size and plays on the default board
+//   records, varint of (ticks since last record << 3) | input
+//   end record with input INPUT_NONE at the last tick
+//   footer, varints of final score, level and lines
+// gravity ticks are not stored, they follow from the tick numbers
+const char REPLAY_MAGIC[4] = { 'F', 'B', 'R', 'P' };
+const uint8_t REPLAY_VERSION = 2;
+const int REPLAY_HEADER_SIZE = 16;
+const int REPLAY_V1_HEADER_SIZE = 13;
+const int REPLAY_INPUT_BITS = 3;
+
+static_assert(INPUT_TOTAL <= 1 << REPLAY_INPUT_BITS, "every input needs a code in a record");
+
+// records inputs of a game into memory
+class ReplayWriter
+{
+public:
+	// constructor
+	ReplayWriter();
+
+	// start recording a game on a board
+	void begin(uint64_t seed, int cols = SQUARES_PER_ROW, int rows = PLAYFIELD_ROWS);
+
+	// record input handled before update of tick
+	void record(int tick, GameInput input);
+
+	// end recording with tick count and final result
+	void finish(int tick, int score, int level, int lines);
+
+	// getter
+	const uint8_t* getData();
+	size_t getSize();
+	bool isFinished();
+
+	// write finished replay to file
+	bool saveToFile(const char* path);
+
+private:
+	void writeVarint(uint64_t value);
+
+	std::vector<uint8_t> mData;
+	// tick of last record
+	int mLastTick;
+	bool mFinished;
+};
+
+// reads a replay from memory, the data must stay alive while reading
+class ReplayReader
+{
+public:
+	// constructor
+	ReplayReader();
+
+	// check header, return false when data is not a replay
+	bool open(const uint8_t* data, size_t size);
+
+	// get next input and its tick, false after the last input,
+	// then end tick and footer are available
+	bool next(int* tick, GameInput* input);
+
+	// getter
+	uint64_t getSeed();
+	int getColumns();
+	int getRows();
+	int getEndTick();
+	int getScore();
+	int getLevel();
+	int getLines();
+
+	// false when data ended early or holds a bad record
+	bool isValid();
+
+	// bytes read so far, the whole replay once next returned false
+	size_t getSize();
+
+	// read a whole file into memory
+	static bool loadFromFile(const char* path, std::vector<uint8_t>* data);
+
+private:
+	bool readVarint(uint64_t* value);
+
+	const uint8_t* mData;
+	size_t mSize;
+	size_t mPosition;
+
+	uint64_t mSeed;
+	int mColumns;
+	int mRows;
+	int mTick;
+	bool mEnded;
+	bool mValid;
+
+	// footer
+	int mScore;
+	int mLevel;
+	int mLines;
+};
+
+// feeds a replay into a game tick by tick
+class ReplayPlayer
+{
+public:
+	// constructor
+	ReplayPlayer();
+
+	// reset game with seed and board size of replay
+	void begin(ReplayReader* reader, GameState* game);
+
+	// apply inputs recorded for current tick and advance game by one tick,
+	// return game events
+	int step();
+
+	// check if every recorded tick is played
+	bool isFinished();
+
+	// play to the end at full speed, return true when result matches footer
+	bool run();
+
+	// check if game result equals footer of replay
+	bool isMatching();
+
+private:
+	ReplayReader* mReader;
+	GameState* mGame;
+
+	// next input waiting for its tick
+	bool mHasInput;
+	int mInputTick;
+	GameInput mInput;
+
+	bool mFinished;
+};
+
+ReplayWriter::ReplayWriter():
+	mLastTick(0),mFinished(false){
+}
+
+void ReplayWriter::begin(uint64_t seed, int cols, int rows) {
+	mData.clear();
+	for (int i = 0; i < 4; i++) {
+		mData.push_back((uint8_t)REPLAY_MAGIC[i]);
+	}
+	mData.push_back(REPLAY_VERSION);
+	for (int i = 0; i < 8; i++) {
+		mData.push_back((uint8_t)(seed >> (i * 8)));
+	}
+	mData.push_back((uint8_t)cols);
+	mData.push_back((uint8_t)rows);
+	mData.push_back((uint8_t)(rows >> 8));
+	mLastTick = 0;
+	mFinished = false;
+}
+
+void ReplayWriter::record(int tick, GameInput input) {
+	if (mFinished || input == INPUT_NONE) {
+		return;
+	}
+	// one byte for inputs less than 16 ticks apart
+	writeVarint(((uint64_t)(tick - mLastTick) << REPLAY_INPUT_BITS) | input);
+	mLastTick = tick;
+}
+
+void ReplayWriter::finish(int tick, int score, int level, int lines) {
+	if (mFinished) {
+		return;
+	}
+	writeVarint((uint64_t)(tick - mLastTick) << REPLAY_INPUT_BITS);
+	writeVarint(score);
+	writeVarint(level);
+	writeVarint(lines);
+	mFinished = true;
+}
+
+const uint8_t* ReplayWriter::getData() {
+	return mData.data();
+}
+
+size_t ReplayWriter::getSize() {
+	return mData.size();
+}
+
+bool ReplayWriter::isFinished() {
+	return mFinished;
+}
+
+bool ReplayWriter::saveToFile(const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("Unable to write replay %s!\n", path);
+		return false;
+	}
+	bool success = fwrite(mData.data(), 1, mData.size(), file) == mData.size();
+	fclose(file);
+	return success;
+}
+
+void ReplayWriter::writeVarint(uint64_t value) {
+	// seven bits per byte, high bit set when more bytes follow
+	while (value >= 0x80) {
+		mData.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	mData.push_back((uint8_t)value);
+}
+
+ReplayReader::ReplayReader():
+	mData(NULL),mSize(0),mPosition(0),mSeed(0),mColumns(SQUARES_PER_ROW),mRows(PLAYFIELD_ROWS),mTick(0),mEnded(false),mValid(false),
+	mScore(0),mLevel(0),mLines(0){
+}
+
+bool ReplayReader::open(const uint8_t* data, size_t size) {
+	mData = data;
+	mSize = size;
+	mPosition = 0;
+	mTick = 0;
+	mEnded = false;
+	mScore = 0;
+	mLevel = 0;
+	mLines = 0;
+	// older version is still read, its games are on the default board
+	mValid = size >= (size_t)REPLAY_V1_HEADER_SIZE && memcmp(data, REPLAY_MAGIC, 4) == 0 &&
+		(data[4] == 1 || (data[4] == REPLAY_VERSION && size >= (size_t)REPLAY_HEADER_SIZE));
+	if (!mValid) {
+		mEnded = true;
+		return false;
+	}
+	mSeed = 0;
+	for (int i = 0; i < 8; i++) {
+		mSeed |= (uint64_t)data[5 + i] << (i * 8);
+	}
+	mColumns = SQUARES_PER_ROW;
+	mRows = PLAYFIELD_ROWS;
+	mPosition = REPLAY_V1_HEADER_SIZE;
+	if (data[4] == REPLAY_VERSION) {
+		mColumns = data[13];
+		mRows = data[14] | (data[15] << 8);
+		mPosition = REPLAY_HEADER_SIZE;
+	}
+	// board size is not clamped, a game on another size would not match
+	if (mColumns < MIN_BOARD_COLUMNS || mColumns > MAX_BOARD_COLUMNS || mRows < MIN_BOARD_ROWS || mRows > MAX_BOARD_ROWS) {
+		mValid = false;
+		mEnded = true;
+		return false;
+	}
+	return true;
+}
+
+bool ReplayReader::next(int* tick, GameInput* input) {
+	if (mEnded) {
+		return false;
+	}
+	uint64_t value;
+	if (!readVarint(&value)) {
+		mEnded = true;
+		return false;
+	}
+	uint64_t delta = value >> REPLAY_INPUT_BITS;
+	int type = (int)(value & ((1 << REPLAY_INPUT_BITS) - 1));
+	if (delta > (uint64_t)(INT32_MAX - mTick) || type >= INPUT_TOTAL) {
+		mValid = false;
+		mEnded = true;
+		return false;
+	}
+	mTick += (int)delta;
+
+	// end record, read footer
+	if (type == INPUT_NONE) {
+		uint64_t score, level, lines;
+		if (readVarint(&score) && readVarint(&level) && readVarint(&lines)) {
+			mScore = (int)score;
+			mLevel = (int)level;
+			mLines = (int)lines;
+		}
+		mEnded = true;
+		return false;
+	}
+	*tick = mTick;
+	*input = (GameInput)type;
+	return true;
+}
+
+uint64_t ReplayReader::getSeed() {
+	return mSeed;
+}
+
+int ReplayReader::getColumns() {
+	return mColumns;
+}
+
+int ReplayReader::getRows() {
+	return mRows;
+}
+
+int ReplayReader::getEndTick() {
+	return mTick;
+}
+
+int ReplayReader::getScore() {
+	return mScore;
+}
+
+int ReplayReader::getLevel() {
+	return mLevel;
+}
+
+int ReplayReader::getLines() {
+	return mLines;
+}
+
+bool ReplayReader::isValid() {
+	return mValid;
+}
+
+size_t ReplayReader::getSize() {
+	return mPosition;
+}
+
+bool ReplayReader::loadFromFile(const char* path, std::vector<uint8_t>* data) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("Unable to open replay %s!\n", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	data->resize(size > 0 ? size : 0);
+	bool success = size > 0 && fread(data->data(), 1, size, file) == (size_t)size;
+	fclose(file);
+	return success;
+}
+
+bool ReplayReader::readVarint(uint64_t* value) {
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (mPosition >= mSize) {
+			mValid = false;
+			return false;
+		}
+		uint8_t byte = mData[mPosition++];
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	// too many bytes
+	mValid = false;
+	return false;
+}
+
+ReplayPlayer::ReplayPlayer():
+	mReader(NULL),mGame(NULL),mHasInput(false),mInputTick(0),mInput(INPUT_NONE),mFinished(true){
+}
+
+void ReplayPlayer::begin(ReplayReader* reader, GameState* game) {
+	mReader = reader;
+	mGame = game;
+	mGame->setBoardSize(reader->getColumns(), reader->getRows());
+	mGame->reset(reader->getSeed());
+	mHasInput = mReader->next(&mInputTick, &mInput);
+	mFinished = !mReader->isValid();
+}
+
+int ReplayPlayer::step() {
+	int events = EVENT_NONE;
+	if (mFinished) {
+		return events;
+	}
+	// inputs handled before this tick
+	while (mHasInput && mInputTick <= mGame->getTicks()) {
+		events |= mGame->handleInput(mInput);
+		mHasInput = mReader->next(&mInputTick, &mInput);
+	}
+	if ((!mHasInput && mGame->getTicks() >= mReader->getEndTick()) || mGame->isOver()) {
+		mFinished = true;
+		return events;
+	}
+	return events | mGame->update();
+}
+
+bool ReplayPlayer::isFinished() {
+	return mFinished;
+}
+
+bool ReplayPlayer::run() {
+	while (!mFinished) {
+		step();
+	}
+	return isMatching();
+}
+
+bool ReplayPlayer::isMatching() {
+	return mReader->isValid() && mGame->getTicks() == mReader->getEndTick() &&
+		mGame->getScore() == mReader->getScore() && mGame->getLevel() == mReader->getLevel() &&
+		mGame->getLines() == mReader->getLines();
+}
\ No newline at end of file
@@ -0,0 +1,402 @@
+//////////////////////////////////////////////////////////////////////////
+// SearchPlayer.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "../include/AutoPlayer.h"
+#include "../include/ThreadPool.h"
+#include "../include/TranspositionTable.h"
+
+// children of a node searched deeper, best by heuristic score first
+const int SEARCH_BEAM_WIDTH = 6;
+// time for one block in milliseconds, 0 for no limit
+const int SEARCH_TIME_BUDGET = 100;
+// entries of transposition table
+const int SEARCH_TABLE_SIZE = 1 << 18;
+// known blocks are the focus block and the preview queue
+const int SEARCH_KNOWN_BLOCKS = 1 + PREVIEW_COUNT;
+// score of a board where the block does not fit
+const float SEARCH_LOSS_SCORE = -1.0e6f;
+
+// autoplayer that looks ahead, a beam search over known blocks and
+// optionally an expectimax level over the unknown block after them,
+// deepened one level at a time until the time budget is used
+class SearchPlayer : public AutoPlayer
+{
+public:
+	// constructor, pool splits the search over threads, NULL searches
+	// on one thread, async searches run while the game goes on
+	SearchPlayer(ThreadPool* pool = NULL, bool async = false);
+
+	// prepare for a new game
+	void reset(uint64_t seed);
+
+	// get input that moves focus block toward its target
+	GameInput getInput(GameState* game);
+
+	// settings
+	void setTimeBudget(int milliseconds);
+	void setBeamWidth(int width);
+	void setDepth(int knownBlocks, bool unknownBlock);
+
+	// search on calling thread, false when no placement fits
+	bool search(GameState* game, Placement* placement);
+
+	~SearchPlayer();
+
+private:
+	// copy of game taken when search starts, the game can go on meanwhile
+	struct SearchRoot {
+		SearchBoard board;
+		BlockTypes types[SEARCH_KNOWN_BLOCKS];
+		int rotation;
+		int col;
+		int row;
+	};
+
+	void takeSnapshot(GameState* game, SearchRoot* root);
+
+	// deepen search from root until time is up or all levels are searched
+	bool runSearch(Placement* placement);
+
+	// search root placements of one level, false when time was up
+	bool searchLevel(int levels, Placement* placement);
+
+	// get best score reachable from board, depth is the number of
+	// blocks placed, levels the number of blocks searched
+	float searchBoard(SearchBoard* board, int depth, int levels);
+
+	// get best heuristic score of one block placed on board
+	float getBestPlacementScore(SearchBoard* board, BlockTypes type);
+
+	// check if search has to stop
+	bool isTimeUp();
+
+	// hand the snapshot in mRoot to the worker
+	void startSearch();
+
+	// wait for running async search
+	void stopSearch();
+
+	// worker loop, one search per request until the player is destroyed
+	void work();
+
+	ThreadPool* mPool;
+	bool mAsync;
+
+	int mTimeBudget;
+	int mBeamWidth;
+	int mKnownBlocks;
+	bool mUnknownBlock;
+
+	TranspositionTable mTable;
+	SearchRoot mRoot;
+	std::chrono::steady_clock::time_point mDeadline;
+	std::atomic<bool> mTimeUp;
+	std::atomic<bool> mCancel;
+
+	// async search and its result, one worker thread lives as long as
+	// the player and sleeps between blocks
+	std::thread mWorker;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mIdle;
+	bool mRequested;
+	bool mBusy;
+	bool mQuit;
+	bool mSearching;
+	std::atomic<bool> mReady;
+	bool mFound;
+	Placement mResult;
+};
+
+SearchPlayer::SearchPlayer(ThreadPool* pool, bool async):
+	mPool(pool),mAsync(async),mTimeBudget(SEARCH_TIME_BUDGET),mBeamWidth(SEARCH_BEAM_WIDTH),
+	mKnownBlocks(SEARCH_KNOWN_BLOCKS),mUnknownBlock(true),mTable(SEARCH_TABLE_SIZE),
+	mTimeUp(false),mCancel(false),mRequested(false),mBusy(false),mQuit(false),mSearching(false),mReady(false),mFound(false){
+}
+
+SearchPlayer::~SearchPlayer()
+{
+	stopSearch();
+	if (mWorker.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mWake.notify_one();
+		mWorker.join();
+	}
+}
+
+void SearchPlayer::reset(uint64_t seed) {
+	stopSearch();
+	AutoPlayer::reset(seed);
+}
+
+void SearchPlayer::setTimeBudget(int milliseconds) {
+	mTimeBudget = milliseconds;
+}
+
+void SearchPlayer::setBeamWidth(int width) {
+	mBeamWidth = width < 1 ? 1 : (width > MAX_PLACEMENTS ? MAX_PLACEMENTS : width);
+}
+
+void SearchPlayer::setDepth(int knownBlocks, bool unknownBlock) {
+	mKnownBlocks = knownBlocks < 1 ? 1 : (knownBlocks > SEARCH_KNOWN_BLOCKS ? SEARCH_KNOWN_BLOCKS : knownBlocks);
+	mUnknownBlock = unknownBlock;
+}
+
+GameInput SearchPlayer::getInput(GameState* game) {
+	// plan once for every block
+	if (mPlannedBlock != game->getBlockCount()) {
+		mPlannedBlock = game->getBlockCount();
+		clearTarget();
+		stopSearch();
+		if (mAsync) {
+			takeSnapshot(game, &mRoot);
+			startSearch();
+		} else if (search(game, &mResult)) {
+			setTarget(&mResult);
+		}
+	}
+	if (mSearching) {
+		// block falls while search is running
+		if (!mReady) {
+			return INPUT_NONE;
+		}
+		stopSearch();
+		if (mFound) {
+			setTarget(&mResult);
+		}
+	}
+	return steer(game->getFocusBlock());
+}
+
+bool SearchPlayer::search(GameState* game, Placement* placement) {
+	takeSnapshot(game, &mRoot);
+	return runSearch(placement);
+}
+
+void SearchPlayer::takeSnapshot(GameState* game, SearchRoot* root) {
+	copyBoard(game->getPlayfield(), &root->board);
+	Block* block = game->getFocusBlock();
+	root->types[0] = block->getType();
+	for (int i = 1; i < SEARCH_KNOWN_BLOCKS; i++) {
+		root->types[i] = game->getNextBlock(i - 1)->getType();
+	}
+	root->rotation = block->getRotation();
+	root->col = block->getColumn();
+	root->row = block->getRow();
+}
+
+bool SearchPlayer::runSearch(Placement* placement) {
+	mDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(mTimeBudget);
+	mTimeUp = false;
+	mTable.newSearch();
+	int maxLevels = mKnownBlocks + (mUnknownBlock ? 1 : 0);
+	placement->rotation = -1;
+	// one level always finishes, deeper levels only count when complete
+	for (int levels = 1; levels <= maxLevels; levels++) {
+		Placement best;
+		if (!searchLevel(levels, &best)) {
+			break;
+		}
+		*placement = best;
+		if (best.rotation < 0) {
+			break;
+		}
+	}
+	return placement->rotation >= 0;
+}
+
+bool SearchPlayer::searchLevel(int levels, Placement* placement) {
+	Placement placements[MAX_PLACEMENTS];
+	float scores[MAX_PLACEMENTS];
+	int count = getPlacements(&mRoot.board, mRoot.types[0], mRoot.rotation, mRoot.col, mRoot.row, placements);
+
+	// every root placement is searched by its own task
+	for (int i = 0; i < count; i++) {
+		Placement* child = &placements[i];
+		float* score = &scores[i];
+		std::function<void()> task = [this, child, score, levels] {
+			SearchBoard board;
+			copyBoard(&mRoot.board, &board);
+			int lines = place(&board, mRoot.types[0], child);
+			*score = (float)(WEIGHT_LINES * lines) + searchBoard(&board, 1, levels);
+		};
+		if (mPool != NULL && levels > 1) {
+			mPool->submit(task);
+		} else {
+			task();
+		}
+	}
+	if (mPool != NULL && levels > 1) {
+		mPool->wait();
+	}
+	// the first level runs even when time is up, so there is always a move
+	if (levels > 1 && isTimeUp()) {
+		return false;
+	}
+
+	placement->rotation = -1;
+	float bestScore = 0;
+	for (int i = 0; i < count; i++) {
+		if (placement->rotation < 0 || scores[i] > bestScore) {
+			bestScore = scores[i];
+			*placement = placements[i];
+		}
+	}
+	return true;
+}
+
+float SearchPlayer::searchBoard(SearchBoard* board, int depth, int levels) {
+	if (depth == levels) {
+		return (float)evaluate(board, 0);
+	}
+	if (depth > 1 && isTimeUp()) {
+		return 0;
+	}
+	// board size is fixed during a search, so only the squares are hashed
+	uint64_t hash = Zobrist::hash(board->rows, board->rowCount) ^ Zobrist::getDepthKey(depth * 8 + levels);
+	float score;
+	if (mTable.probe(hash, &score)) {
+		return score;
+	}
+
+	if (depth >= mKnownBlocks) {
+		// unknown block, average over every type
+		score = 0;
+		for (int type = 0; type < BLOCK_TOTAL; type++) {
+			score += getBestPlacementScore(board, (BlockTypes)type);
+		}
+		score /= BLOCK_TOTAL;
+		mTable.store(hash, score);
+		return score;
+	}
+
+	// children sorted by heuristic score, only the best are searched
+	// deeper, boards are placed again for them instead of keeping all
+	BlockTypes type = mRoot.types[depth];
+	Placement placements[MAX_PLACEMENTS];
+	int lines[MAX_PLACEMENTS];
+	double heuristics[MAX_PLACEMENTS];
+	int order[MAX_PLACEMENTS];
+	Block spawn;
+	spawn.init(type, board->columnCount);
+	int count = getPlacements(board, type, 0, spawn.getColumn(), spawn.getRow(), placements);
+	if (count == 0) {
+		return SEARCH_LOSS_SCORE;
+	}
+	SearchBoard child;
+	for (int i = 0; i < count; i++) {
+		copyBoard(board, &child);
+		lines[i] = place(&child, type, &placements[i]);
+		heuristics[i] = evaluate(&child, lines[i]);
+		order[i] = i;
+	}
+	int width = count < mBeamWidth ? count : mBeamWidth;
+	for (int i = 0; i < width; i++) {
+		for (int j = i + 1; j < count; j++) {
+			if (heuristics[order[j]] > heuristics[order[i]]) {
+				int temp = order[i];
+				order[i] = order[j];
+				order[j] = temp;
+			}
+		}
+	}
+	float best = 0;
+	for (int i = 0; i < width; i++) {
+		int index = order[i];
+		copyBoard(board, &child);
+		place(&child, type, &placements[index]);
+		float childScore = (float)(WEIGHT_LINES * lines[index]) + searchBoard(&child, depth + 1, levels);
+		if (i == 0 || childScore > best) {
+			best = childScore;
+		}
+	}
+	mTable.store(hash, best);
+	return best;
+}
+
+float SearchPlayer::getBestPlacementScore(SearchBoard* board, BlockTypes type) {
+	Placement placements[MAX_PLACEMENTS];
+	Block spawn;
+	spawn.init(type, board->columnCount);
+	int count = getPlacements(board, type, 0, spawn.getColumn(), spawn.getRow(), placements);
+	if (count == 0) {
+		return SEARCH_LOSS_SCORE;
+	}
+	double best = 0;
+	SearchBoard child;
+	for (int i = 0; i < count; i++) {
+		copyBoard(board, &child);
+		int lines = place(&child, type, &placements[i]);
+		double score = evaluate(&child, lines);
+		if (i == 0 || score > best) {
+			best = score;
+		}
+	}
+	return (float)best;
+}
+
+bool SearchPlayer::isTimeUp() {
+	if (mTimeUp || mCancel) {
+		return true;
+	}
+	if (mTimeBudget > 0 && std::chrono::steady_clock::now() >= mDeadline) {
+		mTimeUp = true;
+		return true;
+	}
+	return false;
+}
+
+void SearchPlayer::startSearch() {
+	// worker is started with the first search
+	if (!mWorker.joinable()) {
+		mWorker = std::thread(&SearchPlayer::work, this);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mReady = false;
+		mRequested = true;
+		mBusy = true;
+	}
+	mSearching = true;
+	mWake.notify_one();
+}
+
+void SearchPlayer::stopSearch() {
+	if (mSearching) {
+		mCancel = true;
+		std::unique_lock<std::mutex> lock(mMutex);
+		mIdle.wait(lock, [this] { return !mBusy; });
+		mCancel = false;
+	}
+	mSearching = false;
+}
+
+void SearchPlayer::work() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mWake.wait(lock, [this] { return mRequested || mQuit; });
+		if (mQuit) {
+			return;
+		}
+		mRequested = false;
+		lock.unlock();
+		bool found = runSearch(&mResult);
+		lock.lock();
+		mFound = found;
+		mReady = true;
+		mBusy = false;
+		mIdle.notify_all();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////
+// ThreadPool.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing thread pool, every worker has its own queue and takes
+// tasks from its back, idle workers steal from the front of other queues
+class ThreadPool
+{
+public:
+	// constructor, 0 threads means one per core
+	ThreadPool(int threads = 0);
+
+	// add a task, tasks are spread over worker queues
+	void submit(std::function<void()> task);
+
+	// block until every submitted task is done
+	void wait();
+
+	// getter
+	int getThreadCount();
+
+	~ThreadPool();
+
+private:
+	// queue of a worker, the lock is only contended when stealing
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()> > tasks;
+	};
+
+	// run tasks until pool is destroyed
+	void work(int index);
+
+	// get a task from own queue or another one
+	bool popTask(int index, std::function<void()>* task);
+
+	std::vector<std::thread> mThreads;
+	std::vector<WorkerQueue*> mQueues;
+	// queue for next submitted task
+	std::atomic<unsigned int> mNextQueue;
+
+	// number of tasks not finished
+	std::atomic<int> mPending;
+	// number of tasks waiting in queues
+	std::atomic<int> mQueued;
+	bool mStopping;
+
+	// sleeping workers and waiting callers
+	std::mutex mMutex;
+	std::condition_variable mTaskAdded;
+	std::condition_variable mTasksDone;
+};
+
+ThreadPool::ThreadPool(int threads):
+	mNextQueue(0),mPending(0),mQueued(0),mStopping(false){
+	if (threads <= 0) {
+		threads = (int)std::thread::hardware_concurrency();
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+	for (int i = 0; i < threads; i++) {
+		mQueues.push_back(new WorkerQueue());
+	}
+	for (int i = 0; i < threads; i++) {
+		mThreads.push_back(std::thread(&ThreadPool::work, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mTaskAdded.notify_all();
+	for (size_t i = 0; i < mThreads.size(); i++) {
+		mThreads[i].join();
+	}
+	for (size_t i = 0; i < mQueues.size(); i++) {
+		delete mQueues[i];
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	WorkerQueue* queue = mQueues[mNextQueue++ % mQueues.size()];
+	mPending++;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->tasks.push_back(task);
+	}
+	{
+		// counted under pool lock, so a sleeping worker can not miss it
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueued++;
+	}
+	mTaskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mTasksDone.wait(lock, [this] { return mPending == 0; });
+}
+
+int ThreadPool::getThreadCount() {
+	return (int)mThreads.size();
+}
+
+void ThreadPool::work(int index) {
+	std::function<void()> task;
+	for (;;) {
+		if (popTask(index, &task)) {
+			task();
+			task = nullptr;
+			if (--mPending == 0) {
+				std::lock_guard<std::mutex> lock(mMutex);
+				mTasksDone.notify_all();
+			}
+			continue;
+		}
+		// sleep until a task is added
+		std::unique_lock<std::mutex> lock(mMutex);
+		mTaskAdded.wait(lock, [this] { return mStopping || mQueued > 0; });
+		if (mStopping && mQueued == 0) {
+			return;
+		}
+	}
+}
+
+bool ThreadPool::popTask(int index, std::function<void()>* task) {
+	int count = (int)mQueues.size();
+	// own queue first, newest task is still in cache
+	for (int i = 0; i < count; i++) {
+		WorkerQueue* queue = mQueues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (queue->tasks.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			*task = queue->tasks.back();
+			queue->tasks.pop_back();
+		} else {
+			// steal oldest task of another worker
+			*task = queue->tasks.front();
+			queue->tasks.pop_front();
+		}
+		mQueued--;
+		return true;
+	}
+	return false;
+}
\ No newline at end of file
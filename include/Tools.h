@@ -10,6 +10,8 @@
 #include <SDL/SDL_ttf.h>
 #include <SDL/SDL_image.h>
 
+#include "../include/Constants.h"
+
 // texture wrapper class
 class LTexture
 {
@@ -23,6 +25,12 @@ public:
 	// loads image at specified path
 	bool loadFromFile(SDL_Renderer* renderer, std::string path);
 
+	// creates blank texture
+	bool createBlank(SDL_Renderer* renderer, int width, int height, SDL_TextureAccess access);
+
+	// creates image from surface pixels
+	bool loadFromSurface(SDL_Renderer* renderer, SDL_Surface* surface);
+
 	// creates image from font string
 	bool loadFromRenderedText(SDL_Renderer* renderer, std::string textureText, SDL_Color textColor);
 
@@ -44,6 +52,17 @@ public:
 	// renders texture at given point
 	void render(SDL_Renderer* renderer, int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
 
+	// renders clip of texture stretched to destination rectangle
+	void renderScaled(SDL_Renderer* renderer, SDL_Rect* dest, SDL_Rect* clip = NULL);
+
+	// set self as render target
+	void setAsRenderTarget(SDL_Renderer* renderer);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// renders triangles sampling texture
+	void renderGeometry(SDL_Renderer* renderer, const SDL_Vertex* vertices, int numVertices, const int* indices, int numIndices);
+#endif
+
 	// gets image dimensions
 	int getWidth();
 	int getHeight();
@@ -63,6 +82,7 @@ private:
 LTexture::LTexture(){
 	// initialize
 	mTexture = NULL;
+	mFont = NULL;
 	mWidth = 0;
 	mHeight = 0;
 }
@@ -107,6 +127,51 @@ bool LTexture::loadFromFile(SDL_Renderer* renderer, std::string path)
 	return mTexture != NULL;
 }
 
+bool LTexture::createBlank(SDL_Renderer* renderer, int width, int height, SDL_TextureAccess access) {
+	// get rid of preexisting texture
+	if (mTexture != NULL) {
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+
+	// create uninitialized texture
+	mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, access, width, height);
+	if (mTexture == NULL) {
+		printf("Unable to create blank texture! SDL Error: %s\n", SDL_GetError());
+	} else {
+		mWidth = width;
+		mHeight = height;
+	}
+
+	// return success
+	return mTexture != NULL;
+}
+
+bool LTexture::loadFromSurface(SDL_Renderer* renderer, SDL_Surface* surface) {
+	// get rid of preexisting texture
+	if (mTexture != NULL) {
+		SDL_DestroyTexture(mTexture);
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+
+	// create texture from surface pixels
+	mTexture = SDL_CreateTextureFromSurface(renderer, surface);
+	if (mTexture == NULL) {
+		printf("Unable to create texture from surface! SDL Error: %s\n", SDL_GetError());
+	} else {
+		// get image dimensions
+		mWidth = surface->w;
+		mHeight = surface->h;
+	}
+
+	// return success
+	return mTexture != NULL;
+}
+
 bool LTexture::loadFromRenderedText(SDL_Renderer* renderer, std::string textureText, SDL_Color textColor) {
 	// get rid of preexisting texture
 	if (mTexture != NULL){
@@ -186,9 +251,28 @@ void LTexture::render(SDL_Renderer* renderer, int x, int y, SDL_Rect* clip, doub
 		renderQuad.h = clip->h;
 	}
 
-	// render to screen
-	SDL_RenderCopyEx(renderer, mTexture, clip, &renderQuad, angle, center, flip);
+	// render to screen, plain copy when there is no rotation or flip
+	if (angle == 0.0 && flip == SDL_FLIP_NONE) {
+		SDL_RenderCopy(renderer, mTexture, clip, &renderQuad);
+	} else {
+		SDL_RenderCopyEx(renderer, mTexture, clip, &renderQuad, angle, center, flip);
+	}
+}
+
+void LTexture::renderScaled(SDL_Renderer* renderer, SDL_Rect* dest, SDL_Rect* clip) {
+	SDL_RenderCopy(renderer, mTexture, clip, dest);
+}
+
+void LTexture::setAsRenderTarget(SDL_Renderer* renderer) {
+	// make self render target
+	SDL_SetRenderTarget(renderer, mTexture);
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+void LTexture::renderGeometry(SDL_Renderer* renderer, const SDL_Vertex* vertices, int numVertices, const int* indices, int numIndices) {
+	SDL_RenderGeometry(renderer, mTexture, vertices, numVertices, indices, numIndices);
 }
+#endif
 
 int LTexture::getWidth(){
 	return mWidth;
@@ -196,4 +280,292 @@ int LTexture::getWidth(){
 
 int LTexture::getHeight(){
 	return mHeight;
+}
+
+// max number of sprites in one batch, every square of the largest board
+// plus focus block, ghost block and preview queue, so a frame of any board
+// size takes the same number of draw calls
+const int SPRITE_BATCH_CAPACITY = MAX_BOARD_ROWS * MAX_BOARD_COLUMNS + 4 * (2 + PREVIEW_COUNT);
+
+// sprite batch class, clips of one texture are collected
+// and submitted as one geometry draw call
+class LSpriteBatch
+{
+public:
+	// initializes variables
+	LSpriteBatch();
+
+	// starts a batch for texture
+	void begin(SDL_Renderer* renderer, LTexture* texture);
+
+	// adds clip of texture at given point, alpha below 0xFF blends it
+	void add(int x, int y, SDL_Rect* clip, Uint8 alpha = 0xFF);
+	// adds clip of texture stretched to width and height
+	void add(int x, int y, int w, int h, SDL_Rect* clip, Uint8 alpha = 0xFF);
+	// adds clip modulated by color, white glyphs take the text color
+	void add(int x, int y, int w, int h, SDL_Rect* clip, SDL_Color color);
+
+	// submits collected sprites
+	void flush();
+
+private:
+	SDL_Renderer* mRenderer;
+	LTexture* mTexture;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// four vertices and six indices for every sprite
+	SDL_Vertex mVertices[SPRITE_BATCH_CAPACITY * 4];
+	int mIndices[SPRITE_BATCH_CAPACITY * 6];
+#endif
+	int mSpriteCount;
+};
+
+LSpriteBatch::LSpriteBatch() {
+	// initialize
+	mRenderer = NULL;
+	mTexture = NULL;
+	mSpriteCount = 0;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// indices are the same for every batch, two triangles per sprite
+	for (int i = 0; i < SPRITE_BATCH_CAPACITY; i++) {
+		mIndices[i * 6] = i * 4;
+		mIndices[i * 6 + 1] = i * 4 + 1;
+		mIndices[i * 6 + 2] = i * 4 + 2;
+		mIndices[i * 6 + 3] = i * 4 + 2;
+		mIndices[i * 6 + 4] = i * 4 + 3;
+		mIndices[i * 6 + 5] = i * 4;
+	}
+#endif
+}
+
+void LSpriteBatch::begin(SDL_Renderer* renderer, LTexture* texture) {
+	mRenderer = renderer;
+	mTexture = texture;
+	mSpriteCount = 0;
+}
+
+void LSpriteBatch::add(int x, int y, SDL_Rect* clip, Uint8 alpha) {
+	add(x, y, clip->w, clip->h, clip, alpha);
+}
+
+void LSpriteBatch::add(int x, int y, int w, int h, SDL_Rect* clip, Uint8 alpha) {
+	SDL_Color color = { 0xFF,0xFF,0xFF,alpha };
+	add(x, y, w, h, clip, color);
+}
+
+void LSpriteBatch::add(int x, int y, int w, int h, SDL_Rect* clip, SDL_Color color) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// submit when full
+	if (mSpriteCount == SPRITE_BATCH_CAPACITY) {
+		flush();
+	}
+
+	// texture coordinates of clip
+	float u1 = (float)clip->x / mTexture->getWidth();
+	float v1 = (float)clip->y / mTexture->getHeight();
+	float u2 = (float)(clip->x + clip->w) / mTexture->getWidth();
+	float v2 = (float)(clip->y + clip->h) / mTexture->getHeight();
+
+	// corners clockwise from top left
+	SDL_Vertex* vertex = &mVertices[mSpriteCount * 4];
+	vertex[0] = { { (float)x, (float)y }, color, { u1, v1 } };
+	vertex[1] = { { (float)(x + w), (float)y }, color, { u2, v1 } };
+	vertex[2] = { { (float)(x + w), (float)(y + h) }, color, { u2, v2 } };
+	vertex[3] = { { (float)x, (float)(y + h) }, color, { u1, v2 } };
+	mSpriteCount++;
+#else
+	// no geometry rendering, copy sprite directly
+	bool tinted = color.r != 0xFF || color.g != 0xFF || color.b != 0xFF;
+	if (tinted) {
+		mTexture->setColor(color.r, color.g, color.b);
+	}
+	if (color.a != 0xFF) {
+		mTexture->setAlpha(color.a);
+	}
+	SDL_Rect dest = { x, y, w, h };
+	mTexture->renderScaled(mRenderer, &dest, clip);
+	if (tinted) {
+		mTexture->setColor(0xFF, 0xFF, 0xFF);
+	}
+	if (color.a != 0xFF) {
+		mTexture->setAlpha(0xFF);
+	}
+#endif
+}
+
+void LSpriteBatch::flush() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (mSpriteCount > 0) {
+		mTexture->renderGeometry(mRenderer, mVertices, mSpriteCount * 4, mIndices, mSpriteCount * 6);
+		mSpriteCount = 0;
+	}
+#endif
+}
+
+// first and last printable ascii glyph
+const int FIRST_GLYPH = 32;
+const int LAST_GLYPH = 126;
+const int GLYPH_COUNT = LAST_GLYPH - FIRST_GLYPH + 1;
+// glyphs per row in atlas
+const int GLYPHS_PER_ROW = 16;
+
+// bitmap font class, all printable ascii glyphs of a font are
+// rendered once into an atlas texture and texts are drawn from it
+class LBitmapFont
+{
+public:
+	// initializes variables
+	LBitmapFont();
+
+	// deallocates memory
+	~LBitmapFont();
+
+	// renders glyphs of font at specified path into atlas
+	bool loadFromFile(SDL_Renderer* renderer, std::string path, int size);
+
+	// deallocates atlas
+	void freeFont();
+
+	// starts batch on atlas, texts added until flush are one draw call
+	void beginText(LSpriteBatch* batch, SDL_Renderer* renderer);
+
+	// adds glyphs of text at given point to batch
+	void addText(LSpriteBatch* batch, int x, int y, const char* text, SDL_Color color);
+
+	// gets text dimensions
+	int getTextWidth(const char* text);
+	int getLineHeight();
+
+private:
+	// atlas texture for glyphs
+	LTexture mAtlas;
+
+	// atlas clips and advances of glyphs
+	SDL_Rect mGlyphClips[GLYPH_COUNT];
+	int mGlyphAdvances[GLYPH_COUNT];
+
+	// height of a text line
+	int mLineHeight;
+};
+
+LBitmapFont::LBitmapFont() {
+	// initialize
+	mLineHeight = 0;
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		mGlyphClips[i] = { 0,0,0,0 };
+		mGlyphAdvances[i] = 0;
+	}
+}
+
+LBitmapFont::~LBitmapFont() {
+	// deallocate
+	freeFont();
+}
+
+bool LBitmapFont::loadFromFile(SDL_Renderer* renderer, std::string path, int size) {
+	// get rid of preexisting atlas
+	freeFont();
+
+	TTF_Font* font = TTF_OpenFont(path.c_str(), size);
+	if (font == NULL) {
+		printf("Unable to load font %s! SDL_ttf Error: %s\n", path.c_str(), TTF_GetError());
+		return false;
+	}
+	mLineHeight = TTF_FontHeight(font);
+
+	// render every glyph in white, color is modulated when drawing
+	SDL_Color white = { 0xFF,0xFF,0xFF,0xFF };
+	SDL_Surface* glyphSurfaces[GLYPH_COUNT];
+	int cellWidth = 0;
+	int cellHeight = mLineHeight;
+	int minX, maxX, minY, maxY;
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		glyphSurfaces[i] = TTF_RenderGlyph_Solid(font, (Uint16)(FIRST_GLYPH + i), white);
+		if (TTF_GlyphMetrics(font, (Uint16)(FIRST_GLYPH + i), &minX, &maxX, &minY, &maxY, &mGlyphAdvances[i]) == -1) {
+			mGlyphAdvances[i] = 0;
+		}
+		if (glyphSurfaces[i] != NULL) {
+			if (glyphSurfaces[i]->w > cellWidth) {
+				cellWidth = glyphSurfaces[i]->w;
+			}
+			if (glyphSurfaces[i]->h > cellHeight) {
+				cellHeight = glyphSurfaces[i]->h;
+			}
+		}
+	}
+	TTF_CloseFont(font);
+
+	// pack glyphs into one transparent surface
+	int rows = (GLYPH_COUNT + GLYPHS_PER_ROW - 1) / GLYPHS_PER_ROW;
+	SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, cellWidth * GLYPHS_PER_ROW, cellHeight * rows, 32, SDL_PIXELFORMAT_RGBA32);
+	if (atlasSurface == NULL) {
+		printf("Unable to create glyph atlas! SDL Error: %s\n", SDL_GetError());
+	} else {
+		SDL_FillRect(atlasSurface, NULL, SDL_MapRGBA(atlasSurface->format, 0, 0, 0, 0));
+		for (int i = 0; i < GLYPH_COUNT; i++) {
+			if (glyphSurfaces[i] == NULL) {
+				continue;
+			}
+			mGlyphClips[i] = { (i % GLYPHS_PER_ROW) * cellWidth, (i / GLYPHS_PER_ROW) * cellHeight, glyphSurfaces[i]->w, glyphSurfaces[i]->h };
+			SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &mGlyphClips[i]);
+		}
+
+		// create atlas texture
+		if (mAtlas.loadFromSurface(renderer, atlasSurface)) {
+			mAtlas.setBlendMode(SDL_BLENDMODE_BLEND);
+		}
+		SDL_FreeSurface(atlasSurface);
+	}
+
+	// get rid of glyph surfaces
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		if (glyphSurfaces[i] != NULL) {
+			SDL_FreeSurface(glyphSurfaces[i]);
+		}
+	}
+
+	// return success
+	return mAtlas.getWidth() > 0;
+}
+
+void LBitmapFont::freeFont() {
+	mAtlas.freeTexture();
+	mLineHeight = 0;
+}
+
+void LBitmapFont::beginText(LSpriteBatch* batch, SDL_Renderer* renderer) {
+	batch->begin(renderer, &mAtlas);
+}
+
+void LBitmapFont::addText(LSpriteBatch* batch, int x, int y, const char* text, SDL_Color color) {
+	int glyph;
+	// text is opaque, only red, green and blue tint the glyphs
+	color.a = 0xFF;
+	for (const char* c = text; *c != '\0'; c++) {
+		glyph = (unsigned char)*c - FIRST_GLYPH;
+		if (glyph < 0 || glyph >= GLYPH_COUNT) {
+			continue;
+		}
+		if (mGlyphClips[glyph].w > 0) {
+			batch->add(x, y, mGlyphClips[glyph].w, mGlyphClips[glyph].h, &mGlyphClips[glyph], color);
+		}
+		x += mGlyphAdvances[glyph];
+	}
+}
+
+int LBitmapFont::getTextWidth(const char* text) {
+	int width = 0;
+	int glyph;
+	for (const char* c = text; *c != '\0'; c++) {
+		glyph = (unsigned char)*c - FIRST_GLYPH;
+		if (glyph >= 0 && glyph < GLYPH_COUNT) {
+			width += mGlyphAdvances[glyph];
+		}
+	}
+	return width;
+}
+
+int LBitmapFont::getLineHeight() {
+	return mLineHeight;
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////
+// TranspositionTable.h
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/Playfield.h"
+#include "../include/Random.h"
+
+// Zobrist keys, a board hash is the XOR of the keys of its squares
+class Zobrist
+{
+public:
+	// get hash of row masks of a board of any size
+	static uint64_t hash(const uint64_t* rows, int rowCount);
+
+	// get key to mix search depth into a hash, depth is below 64
+	static uint64_t getDepthKey(int depth);
+
+private:
+	// fill keys from a fixed seed, so hashes are the same in every run
+	static bool setupKeys();
+
+	static uint64_t sSquareKeys[MAX_BOARD_ROWS][MAX_BOARD_COLUMNS];
+	static uint64_t sDepthKeys[64];
+	static bool sKeysReady;
+};
+
+// init static keys
+uint64_t Zobrist::sSquareKeys[MAX_BOARD_ROWS][MAX_BOARD_COLUMNS];
+uint64_t Zobrist::sDepthKeys[64];
+bool Zobrist::sKeysReady = Zobrist::setupKeys();
+
+uint64_t Zobrist::hash(const uint64_t* rows, int rowCount) {
+	uint64_t hash = 0;
+	for (int row = 0; row < rowCount; row++) {
+		// only set bits cost time, empty rows are skipped at once
+		for (uint64_t mask = rows[row]; mask != 0; mask &= mask - 1) {
+			hash ^= sSquareKeys[row][Playfield::getLowestBit(mask)];
+		}
+	}
+	return hash;
+}
+
+uint64_t Zobrist::getDepthKey(int depth) {
+	return sDepthKeys[depth & 63];
+}
+
+bool Zobrist::setupKeys() {
+	Random random(0x5EED);
+	for (int row = 0; row < MAX_BOARD_ROWS; row++) {
+		for (int col = 0; col < MAX_BOARD_COLUMNS; col++) {
+			sSquareKeys[row][col] = ((uint64_t)random.next() << 32) | random.next();
+		}
+	}
+	for (int i = 0; i < 64; i++) {
+		sDepthKeys[i] = ((uint64_t)random.next() << 32) | random.next();
+	}
+	return true;
+}
+
+// hash table of search results shared by search threads without locks,
+// every entry stores key XOR data next to data, so an entry torn by two
+// writers fails the key check instead of returning a wrong score
+class TranspositionTable
+{
+public:
+	// constructor, size is rounded down to a power of two
+	TranspositionTable(int size);
+
+	// forget all entries in constant time
+	void newSearch();
+
+	// get stored score of hash, false when there is none
+	bool probe(uint64_t hash, float* score);
+
+	// store score of hash
+	void store(uint64_t hash, float score);
+
+	~TranspositionTable();
+
+private:
+	struct Entry {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+
+	Entry* mEntries;
+	uint64_t mMask;
+	// entries of older searches are ignored
+	uint32_t mGeneration;
+};
+
+TranspositionTable::TranspositionTable(int size):
+	mMask(0),mGeneration(1){
+	uint64_t entries = 1;
+	while (entries * 2 <= (uint64_t)size) {
+		entries *= 2;
+	}
+	mEntries = new Entry[entries];
+	for (uint64_t i = 0; i < entries; i++) {
+		mEntries[i].check.store(0, std::memory_order_relaxed);
+		mEntries[i].data.store(0, std::memory_order_relaxed);
+	}
+	mMask = entries - 1;
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	delete[] mEntries;
+}
+
+void TranspositionTable::newSearch() {
+	mGeneration++;
+}
+
+bool TranspositionTable::probe(uint64_t hash, float* score) {
+	Entry* entry = &mEntries[hash & mMask];
+	uint64_t data = entry->data.load(std::memory_order_relaxed);
+	uint64_t check = entry->check.load(std::memory_order_relaxed);
+	if ((check ^ data) != hash || (uint32_t)(data >> 32) != mGeneration) {
+		return false;
+	}
+	uint32_t bits = (uint32_t)data;
+	memcpy(score, &bits, sizeof(bits));
+	return true;
+}
+
+void TranspositionTable::store(uint64_t hash, float score) {
+	uint32_t bits;
+	memcpy(&bits, &score, sizeof(bits));
+	// generation in high half, score in low half
+	uint64_t data = ((uint64_t)mGeneration << 32) | bits;
+	Entry* entry = &mEntries[hash & mMask];
+	entry->check.store(hash ^ data, std::memory_order_relaxed);
+	entry->data.store(data, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -28,16 +28,20 @@
 #include <cstdio>
 #include <ctime>
 #include <cmath>
+#include <cstring>
 
 #include <stack>
-#include <vector>
+#include <algorithm>
 
 #include <SDL/SDL_mixer.h>
 
 #include "../include/Constants.h"
 #include "../include/Enums.h"
 #include "../include/Tools.h"
-#include "../include/Block.h"
+#include "../include/GameState.h"
+#include "../include/Replay.h"
+#include "../include/SearchPlayer.h"
+#include "../include/FrameScheduler.h"
 
 using namespace std;
 
@@ -51,8 +55,8 @@ std::stack<StateStruct> gStageStack; // stack for game state pointer
 SDL_Window* gWindow = NULL; // SDL window pointer
 SDL_Renderer* gRenderer = NULL; // renderer pointer
 SDL_Event gEvent; // SDL event struct
-int gTimer; // timer
-LTexture gTextTexture;// texture for text
+FrameScheduler gScheduler; // frame scheduler
+LBitmapFont gFont;// glyph atlas for text
 Mix_Music* gMusic = NULL;// music that will be played
 Mix_Chunk* gWinSound = NULL;// sound effects
 Mix_Chunk* gLoseSound = NULL;
@@ -61,12 +65,21 @@ Mix_Chunk* gCollisionSound = NULL;
 Mix_Chunk* gKeydownSound = NULL;
 
 LTexture gSprite;// texture for background image
-Block* gFocusBlock = NULL;
-Block* gNextBlock = NULL;
-std::vector<Square*> gOldSquares;
-int gScore = 0;
-int gLevel = 1;
-int gFocusBlockSpeed = INITIAL_SPEED;
+LSpriteBatch gSquareBatch;// batch for squares and text
+LTexture gPlayfieldLayer;// background and locked squares
+int gPlayfieldLayerLevel = 0;// level drawn in playfield layer, 0 for invalid layer
+SDL_Rect gBlockClips[BLOCK_TOTAL];// clips for squares of every block type
+GameState gGame;// game logic
+ReplayWriter gReplay;// recording of current game
+std::vector<uint8_t> gReplayData;// replay file being played
+ReplayReader gReplayReader;
+ReplayPlayer gReplayPlayer;
+bool gReplaying = false;// game is driven by replay instead of keyboard
+ThreadPool gSearchPool;// threads of autoplayer search, outlives autoplayer
+SearchPlayer gAutoPlayer(&gSearchPool, true);// plays game in autoplay mode, searches off the render thread
+bool gAutoPlaying = false;// game is driven by autoplayer instead of keyboard
+int gBoardColumns = SQUARES_PER_ROW;// board size of new games
+int gBoardRows = PLAYFIELD_ROWS;
 
 
 // functions
@@ -75,9 +88,14 @@ bool initSDL();
 bool loadMedia();
 void closeSDL();
 
-// init and shutdown game
+// init game
 void init();
-void shutdown();
+
+// start a new game and record it
+void newGame();
+void saveReplay();
+bool startReplay(const char* path);
+bool playReplayHeadless(const char* path);
 
 // functions to handle states of the game
 void Menu();
@@ -92,21 +110,22 @@ void handleMenuInput();
 void handleGameInput();
 void handleExitInput();
 void handleWinLoseInput();
+void handleRenderEvent();
 
-void handleBottomCollision();
-void changeFoculBlock();
-int checkCompletedLindes();
-void checkWin();
-void checkLoss();
+bool isGameRunning();
+void handlePlayerInput(GameInput input);
+void applyInput(GameInput input);
+uint64_t newSeed();
+void handleGameEvents(int events);
 
+SDL_Rect getBackgroundClip();
 void drawBackground();
-
-//collision detection
-bool checkEntityCollisions(Square* square, Direction dir);
-bool checkEntityCollisions(Block* block, Direction dir);
-bool checkWallCollisions(Square* square, Direction dir);
-bool checkWallCollisions(Block* block, Direction dir);
-bool checkRotationCollisions(Block* block);
+void drawScoreText();
+void drawPlayfield(bool dirtyOnly);
+void drawBlock(Block* block);
+void drawGhostBlock(Block* block, int row);
+void drawNextBlock(Block* block, int centerX, int centerY, int median);
+void updatePlayfieldLayer();
 
 
 int main(int argc, char** argv) {
@@ -114,6 +133,22 @@ int main(int argc, char** argv) {
 	//_CrtSetBreakAlloc(1385);
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+	// --replay <file> plays a replay, add --headless to play it at full speed without window,
+	// --board <columns>x<rows> changes board size of new games
+	const char* replayPath = NULL;
+	bool headless = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
+		} else if (strcmp(argv[i], "--headless") == 0) {
+			headless = true;
+		} else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+			sscanf(argv[++i], "%dx%d", &gBoardColumns, &gBoardRows);
+		}
+	}
+	if (headless && replayPath != NULL) {
+		return playReplayHeadless(replayPath) ? 0 : 1;
+	}
 
 	// start up SDL and create window
 	if (!initSDL()) {
@@ -125,12 +160,18 @@ int main(int argc, char** argv) {
 		} else {
 			// game
 			init();
-			// main loop
+			if (replayPath != NULL) {
+				startReplay(replayPath);
+			}
+			// main loop, sleep between frames
 			while (!gStageStack.empty()) {
 				gStageStack.top().StatePointer();
+				gScheduler.waitForNextFrame();
 			}
-
-			shutdown();
+			// print frame times
+			gScheduler.getFrameTimes()->print(stdout);
+			// keep unfinished game
+			saveReplay();
 		}
 	}
 
@@ -161,7 +202,11 @@ bool initSDL() {
 			success = false;
 		} else {
 			// create renderer for window
-			gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+			Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+			if (ENABLE_VSYNC) {
+				rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+			}
+			gRenderer = SDL_CreateRenderer(gWindow, -1, rendererFlags);
 			if (gRenderer == NULL) {
 				printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
 				success = false;
@@ -199,19 +244,30 @@ bool loadMedia() {
 	// loading success flag
 	bool success = true;
 
-	gTextTexture.setFont("../resources/fonts/ARIAL.TTF", 12);
-	//gTextTexture.setFont("../../resources/fonts/ARIAL.TTF", 12);
+	// render glyph atlas
+	//if (!gFont.loadFromFile(gRenderer, "../../resources/fonts/ARIAL.TTF", 12)) {
+	if (!gFont.loadFromFile(gRenderer, "../resources/fonts/ARIAL.TTF", 12)) {
+		printf("Failed to load font!\n");
+		success = false;
+	}
 
 	// load background image
 	if (!gSprite.loadFromFile(gRenderer, "../resources/images/FallingBlocks.bmp")) {
 		printf("Failed to load image!\n");
 		success = false;
 	} else {
+		// image has no alpha channel, blending only lets the ghost block
+		// fade, everything else stays opaque
+		gSprite.setBlendMode(SDL_BLENDMODE_BLEND);
 		int distance = SQUARE_MEDIAN * 2;
 		for (int i = 0; i < BLOCK_TOTAL; i++) {
-			Block::sBlockClips[i] = { SQUARE_START_X+i*distance,SQUARE_START_Y,distance,distance };
+			gBlockClips[i] = { SQUARE_START_X+i*distance,SQUARE_START_Y,distance,distance };
 		}
 	}
+	// create playfield layer, squares are drawn directly without it
+	if (!SDL_RenderTargetSupported(gRenderer) || !gPlayfieldLayer.createBlank(gRenderer, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_TEXTUREACCESS_TARGET)) {
+		printf("Warning: Playfield layer not created!\n");
+	}
 	// load music
 	gMusic = Mix_LoadMUS("../resources/sounds/music.wav");
 	if (gMusic == NULL) {
@@ -250,7 +306,8 @@ bool loadMedia() {
 
 void closeSDL() {
 	// free texture
-	gTextTexture.freeTexture();
+	gFont.freeFont();
+	gPlayfieldLayer.freeTexture();
 	gSprite.freeTexture();
 
 	// free the sound effects
@@ -283,12 +340,9 @@ void closeSDL() {
 }
 
 void init() {
-	// get the number of ticks
-	gTimer = SDL_GetTicks();
+	// start counting frames
+	gScheduler.start();
 
-	// seed our random number generator
-	srand(time(0));
-	
 	// add a pointer to exit state
 	StateStruct state;
 	state.StatePointer = Exit;
@@ -298,54 +352,96 @@ void init() {
 	state.StatePointer = Menu;
 	gStageStack.push(state);
 
-	// create block
-	gFocusBlock = new Block(BLOCK_START_X, BLOCK_START_Y, &gSprite, (BlockTypes)(rand() % BLOCK_TOTAL));
-	gNextBlock = new Block(NEXT_BLOCK_CIRCLE_X, NEXT_BLOCK_CIRCLE_Y, &gSprite, (BlockTypes)(rand() % BLOCK_TOTAL));
+	// create blocks
+	newGame();
 }
 
-void shutdown() {
-	// deallocate
-	Square** temp1 = gFocusBlock->getSquares();
-	Square** temp2 = gNextBlock->getSquares();
+void newGame() {
+	saveReplay();
+	if (gReplaying) {
+		printf("Replay %s\n", gReplayPlayer.isMatching() ? "matches recorded result" : "does not match recorded result");
+		gReplaying = false;
+	}
+	// size is clamped to board limits, replay records the size used
+	gGame.setBoardSize(gBoardColumns, gBoardRows);
+	gGame.reset(newSeed());
+	gReplay.begin(gGame.getSeed(), gGame.getPlayfield()->getColumns(), gGame.getPlayfield()->getRows());
+	gAutoPlayer.reset(gGame.getSeed());
+	// board size may have changed
+	gPlayfieldLayerLevel = 0;
+}
 
-	for (int i = 0; i < 4; i++) {
-		delete temp1[i];
-		delete temp2[i];
+void saveReplay() {
+	// replays are not recorded again, games without ticks are not saved
+	if (gReplaying || gGame.getTicks() == 0) {
+		return;
 	}
-	delete gFocusBlock;
-	delete gNextBlock;
+	gReplay.finish(gGame.getTicks(), gGame.getScore(), gGame.getLevel(), gGame.getLines());
+	gReplay.saveToFile(REPLAY_PATH);
+}
 
-	// vector saved the pointers
-	for (int i = 0; i < gOldSquares.size(); i++) {
-		delete gOldSquares[i];
+bool startReplay(const char* path) {
+	if (!ReplayReader::loadFromFile(path, &gReplayData) || !gReplayReader.open(gReplayData.data(), gReplayData.size())) {
+		printf("Unable to play replay %s!\n", path);
+		return false;
 	}
-	gOldSquares.clear();
+	gReplayPlayer.begin(&gReplayReader, &gGame);
+	gReplaying = true;
+	gPlayfieldLayerLevel = 0;
+	gAutoPlaying = false;
+
+	// add a pointer to game state
+	StateStruct state;
+	state.StatePointer = Game;
+	gStageStack.push(state);
+	gScheduler.start();
+	return true;
+}
+
+bool playReplayHeadless(const char* path) {
+	std::vector<uint8_t> data;
+	ReplayReader reader;
+	if (!ReplayReader::loadFromFile(path, &data) || !reader.open(data.data(), data.size())) {
+		printf("Unable to play replay %s!\n", path);
+		return false;
+	}
+	// play every tick without waiting
+	clock_t start = clock();
+	ReplayPlayer player;
+	player.begin(&reader, &gGame);
+	bool matching = player.run();
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("Ticks: %d, score: %d, level: %d, lines: %d, %s\n", gGame.getTicks(), gGame.getScore(),
+		gGame.getLevel(), gGame.getLines(), matching ? "matches recorded result" : "does not match recorded result");
+	if (seconds > 0) {
+		printf("Played in %.3f ms, %.0f times faster than real time\n", seconds * 1000,
+			gGame.getTicks() / (double)FRAMES_PER_SECOND / seconds);
+	}
+	return matching;
 }
 
 // game menu
 void Menu() {
 	// stop music
 	Mix_HaltMusic();
-	// control FPS
-	if ((SDL_GetTicks() - gTimer) >= FRAME_RATE) {
-		// handle input
-		handleMenuInput();
-
-		// clear screen
-		SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
-		SDL_RenderClear(gRenderer);
-
-		// render
-		SDL_Color textColor = { 0xFF,0xFF,0xFF };
-		gTextTexture.loadFromRenderedText(gRenderer, "Start (G)ame", textColor);
-		gTextTexture.render(gRenderer, 100, 150);
-		gTextTexture.loadFromRenderedText(gRenderer, "(Q)uit Game", textColor);
-		gTextTexture.render(gRenderer, 100, 170);
-
-		// update
-		SDL_RenderPresent(gRenderer);
-		gTimer = SDL_GetTicks();
-	}
+	// handle input
+	handleMenuInput();
+
+	// clear screen
+	SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
+	SDL_RenderClear(gRenderer);
+
+	// render
+	SDL_Color textColor = { 0xFF,0xFF,0xFF };
+	gFont.beginText(&gSquareBatch, gRenderer);
+	gFont.addText(&gSquareBatch, 100, 150, "Start (G)ame", textColor);
+	gFont.addText(&gSquareBatch, 100, 170, "(A)uto Play", textColor);
+	gFont.addText(&gSquareBatch, 100, 190, "(Q)uit Game", textColor);
+	gSquareBatch.flush();
+
+	// update
+	SDL_RenderPresent(gRenderer);
 }
 
 // main game
@@ -355,137 +451,128 @@ void Game() {
 		Mix_PlayMusic(gMusic, -1);
 	}
 
-	// force down
-	static int force_down_count = 0;
-	static int slider_count = SLIDE_TIME;
-	// control FPS
-	if ((SDL_GetTicks() - gTimer) >= FRAME_RATE) {
-		handleGameInput();
+	handleGameInput();
+	if (!isGameRunning()) {
+		return;// this state is done, exit the function
+	}
 
-		force_down_count++;// increase force down counter
-		if (force_down_count >= gFocusBlockSpeed) {
-			// force to move down
-			if (!checkEntityCollisions(gFocusBlock, DOWN) && !checkWallCollisions(gFocusBlock, DOWN)) {
-				gFocusBlock->move(DOWN);
-				force_down_count = 0;
-			}
-		}
-		// slide when focus block arrive bottom
-		if (checkEntityCollisions(gFocusBlock, DOWN) || checkWallCollisions(gFocusBlock, DOWN)) {
-			slider_count--;
-		} else {
-			slider_count = SLIDE_TIME;
+	// run simulation ticks due since last frame
+	int ticks = gScheduler.consumeTicks();
+	for (int i = 0; i < ticks && isGameRunning(); i++) {
+		if (gReplaying && gReplayPlayer.isFinished()) {
+			// replay is over, back to menu with a new game
+			newGame();
+			gStageStack.pop();
+			return;
 		}
-		if (slider_count <= 0) {
-			slider_count = SLIDE_TIME;
-			handleBottomCollision();
+		if (gAutoPlaying) {
+			applyInput(gAutoPlayer.getInput(&gGame));
+			if (!isGameRunning()) {
+				return;// a hard drop ended the game
+			}
 		}
+		handleGameEvents(gReplaying ? gReplayPlayer.step() : gGame.update());
+	}
 
-		// clear screen
-		SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
-		SDL_RenderClear(gRenderer);
+	// clear screen
+	SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
+	SDL_RenderClear(gRenderer);
 
-		// render
-		// draw background
+	// render
+	// draw background and locked squares
+	if (gPlayfieldLayer.getWidth() > 0) {
+		updatePlayfieldLayer();
+		gPlayfieldLayer.render(gRenderer, 0, 0);
+	} else {
+		// render target is not supported
 		drawBackground();
-		// draw level, score and needed score text
-		SDL_Color textColor = { 0,0,0 };
-		gTextTexture.loadFromRenderedText(gRenderer, "Level: "+to_string(gLevel), textColor);
-		gTextTexture.render(gRenderer,LEVEL_RECT_X, LEVEL_RECT_Y);
-		gTextTexture.loadFromRenderedText(gRenderer, "Score: " + to_string(gScore), textColor);
-		gTextTexture.render(gRenderer, SCORE_RECT_X, SCORE_RECT_Y);
-		gTextTexture.loadFromRenderedText(gRenderer, "Needed: " + to_string(gLevel*POINTS_PER_LEVEL), textColor);
-		gTextTexture.render(gRenderer, NEEDED_SCORE_RECT_X, NEEDED_SCORE_RECT_Y);
-		// draw blocks
-		gFocusBlock->draw(gRenderer);
-		gNextBlock->draw(gRenderer);
-
-		for (int i = 0; i < gOldSquares.size(); i++) {
-			gOldSquares[i]->draw(gRenderer);
-		}
-
-		// update
-		SDL_RenderPresent(gRenderer);
-		gTimer = SDL_GetTicks();
-	}
+		gSquareBatch.begin(gRenderer, &gSprite);
+		drawPlayfield(false);
+		gSquareBatch.flush();
+	}
+	// draw level, score and needed score text
+	drawScoreText();
+	// draw blocks in one batch
+	gSquareBatch.begin(gRenderer, &gSprite);
+	drawGhostBlock(gGame.getFocusBlock(), gGame.getLandingRow());
+	drawBlock(gGame.getFocusBlock());
+	// next block in circle, the rest of the queue smaller beside it
+	drawNextBlock(gGame.getNextBlock(), NEXT_BLOCK_CIRCLE_X, NEXT_BLOCK_CIRCLE_Y, SQUARE_MEDIAN);
+	for (int i = 1; i < PREVIEW_COUNT; i++) {
+		drawNextBlock(gGame.getNextBlock(i), PREVIEW_QUEUE_X, PREVIEW_QUEUE_Y + (i - 1) * PREVIEW_QUEUE_SPACING, PREVIEW_SQUARE_MEDIAN);
+	}
+	gSquareBatch.flush();
+
+	// update
+	SDL_RenderPresent(gRenderer);
 }
 
 // exit state
 void Exit() {
 	// stop music
 	Mix_HaltMusic();
-	// control FPS
-	if ((SDL_GetTicks() - gTimer) >= FRAME_RATE) {
-		handleExitInput();
-		// clear screen
-		SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
-		SDL_RenderClear(gRenderer);
-
-		// render
-		SDL_Color textColor = { 0xFF,0xFF,0xFF };
-		gTextTexture.loadFromRenderedText(gRenderer, "Quit Game (Y or N)?", textColor);
-		gTextTexture.render(gRenderer, 100, 150);
-
-		// update
-		SDL_RenderPresent(gRenderer);
-		gTimer = SDL_GetTicks();
-	}
+	handleExitInput();
+	// clear screen
+	SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
+	SDL_RenderClear(gRenderer);
+
+	// render
+	SDL_Color textColor = { 0xFF,0xFF,0xFF };
+	gFont.beginText(&gSquareBatch, gRenderer);
+	gFont.addText(&gSquareBatch, 100, 150, "Quit Game (Y or N)?", textColor);
+	gSquareBatch.flush();
+
+	// update
+	SDL_RenderPresent(gRenderer);
 }
 
 // game win state
 void GameWin() {
 	// stop music
 	Mix_HaltMusic();
-	// control FPS
-	if ((SDL_GetTicks() - gTimer) >= FRAME_RATE) {
-		handleWinLoseInput();
+	handleWinLoseInput();
 
-		// clear screen
-		SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
-		SDL_RenderClear(gRenderer);
+	// clear screen
+	SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
+	SDL_RenderClear(gRenderer);
 
-		// render
-		SDL_Color textColor = { 0xFF,0xFF,0xFF };
-		gTextTexture.loadFromRenderedText(gRenderer, "You Win!!!", textColor);
-		gTextTexture.render(gRenderer, 100, 150);
-		gTextTexture.loadFromRenderedText(gRenderer, "Quit Game (Y or N)?", textColor);
-		gTextTexture.render(gRenderer, 100, 170);
+	// render
+	SDL_Color textColor = { 0xFF,0xFF,0xFF };
+	gFont.beginText(&gSquareBatch, gRenderer);
+	gFont.addText(&gSquareBatch, 100, 150, "You Win!!!", textColor);
+	gFont.addText(&gSquareBatch, 100, 170, "Quit Game (Y or N)?", textColor);
+	gSquareBatch.flush();
 
-		// update
-		SDL_RenderPresent(gRenderer);
-		gTimer = SDL_GetTicks();
-	}
+	// update
+	SDL_RenderPresent(gRenderer);
 }
 
 // game lose state
 void GameLose() {
 	// stop music
 	Mix_HaltMusic();
-	// control FPS
-	if ((SDL_GetTicks() - gTimer) >= FRAME_RATE) {
-		handleWinLoseInput();
+	handleWinLoseInput();
 
-		// clear screen
-		SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
-		SDL_RenderClear(gRenderer);
+	// clear screen
+	SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0xFF);
+	SDL_RenderClear(gRenderer);
 
-		// render
-		SDL_Color textColor = { 0xFF,0xFF,0xFF };
-		gTextTexture.loadFromRenderedText(gRenderer, "You Lose.", textColor);
-		gTextTexture.render(gRenderer, 120, 150);
-		gTextTexture.loadFromRenderedText(gRenderer, "Quit Game (Y or N)?", textColor);
-		gTextTexture.render(gRenderer, 120, 170);
+	// render
+	SDL_Color textColor = { 0xFF,0xFF,0xFF };
+	gFont.beginText(&gSquareBatch, gRenderer);
+	gFont.addText(&gSquareBatch, 120, 150, "You Lose.", textColor);
+	gFont.addText(&gSquareBatch, 120, 170, "Quit Game (Y or N)?", textColor);
+	gSquareBatch.flush();
 
-		// update
-		SDL_RenderPresent(gRenderer);
-		gTimer = SDL_GetTicks();
-	}
+	// update
+	SDL_RenderPresent(gRenderer);
 }
 
 // receive input handle it for menu state
 void handleMenuInput() {
 	// get event information
 	while (SDL_PollEvent(&gEvent) != 0) {
+		handleRenderEvent();
 		// handle user manually closing game window
 		if (gEvent.type == SDL_QUIT) {
 			// pop all state
@@ -504,9 +591,13 @@ void handleMenuInput() {
 				return;// this state is done, exit the function
 				break;
 			case SDLK_g:
+			case SDLK_a:
 				StateStruct temp;
 				temp.StatePointer = Game;// add a pointer to game state
 				gStageStack.push(temp);
+				gScheduler.start();// count game ticks from now
+				// autoplayer or player goes on with current game
+				gAutoPlaying = gEvent.key.keysym.sym == SDLK_a;
 				return;// this state is done, exit the function
 				break;
 			default:
@@ -520,6 +611,7 @@ void handleMenuInput() {
 void handleGameInput() {
 	// get event information
 	while (SDL_PollEvent(&gEvent) != 0) {
+		handleRenderEvent();
 		// handle user manually closing game window
 		if (gEvent.type == SDL_QUIT) {
 			// pop all state
@@ -537,41 +629,19 @@ void handleGameInput() {
 				return;// this state is done, exit the function
 				break;
 			case SDLK_UP:
-				if (!checkRotationCollisions(gFocusBlock)) {
-					gFocusBlock->rotate();
-					// play effect
-					Mix_PlayChannel(-1, gKeydownSound, 0);
-				} else {
-					// play effect
-					Mix_PlayChannel(-1, gCollisionSound, 0);
-				}
+				handlePlayerInput(INPUT_ROTATE);
 				break;
 			case SDLK_DOWN:
-				if (!checkEntityCollisions(gFocusBlock, DOWN) && !checkWallCollisions(gFocusBlock, DOWN)) {
-					gFocusBlock->move(DOWN);
-					// play effect
-					Mix_PlayChannel(-1, gKeydownSound, 0);
-				} 
+				handlePlayerInput(INPUT_DOWN);
 				break;
 			case SDLK_LEFT:
-				if (!checkEntityCollisions(gFocusBlock, LEFT) && !checkWallCollisions(gFocusBlock, LEFT)) {
-					gFocusBlock->move(LEFT);
-					// play effect
-					Mix_PlayChannel(-1, gKeydownSound, 0);
-				} else {
-					// play effect
-					Mix_PlayChannel(-1, gCollisionSound, 0);
-				}
+				handlePlayerInput(INPUT_LEFT);
 				break;
 			case SDLK_RIGHT:
-				if (!checkEntityCollisions(gFocusBlock, RIGHT) && !checkWallCollisions(gFocusBlock, RIGHT)) {
-					gFocusBlock->move(RIGHT);
-					// play effect
-					Mix_PlayChannel(-1, gKeydownSound, 0);
-				} else {
-					// play effect
-					Mix_PlayChannel(-1, gCollisionSound, 0);
-				}
+				handlePlayerInput(INPUT_RIGHT);
+				break;
+			case SDLK_SPACE:
+				handlePlayerInput(INPUT_HARD_DROP);
 				break;
 			default:
 				break;
@@ -584,6 +654,7 @@ void handleGameInput() {
 void handleExitInput() {
 	// get event information
 	while (SDL_PollEvent(&gEvent) != 0) {
+		handleRenderEvent();
 		// handle user manually closing game window
 		if (gEvent.type == SDL_QUIT) {
 			// pop all state
@@ -623,6 +694,7 @@ void handleExitInput() {
 void handleWinLoseInput() {
 	// get event information
 	while (SDL_PollEvent(&gEvent) != 0) {
+		handleRenderEvent();
 		// handle user manually closing game window
 		if (gEvent.type == SDL_QUIT) {
 			// pop all state
@@ -662,135 +734,81 @@ void handleWinLoseInput() {
 	}
 }
 
-void handleBottomCollision() {
-	changeFoculBlock();
-
-	// get completed line number
-	int lineNums = checkCompletedLindes();
-	if (lineNums > 0) {
-		// play effect
-		Mix_PlayChannel(-1, gEliminateSound, 0);
-		// increase score by line number
-		gScore += lineNums*POINTS_PER_LINE;
-		// check whether if change level
-		if (gScore >= gLevel*POINTS_PER_LEVEL) {
-			gLevel++;
-			gFocusBlockSpeed -= SPEED_CHANGE;
-			checkWin();
-		}
+// render events reach every state, the playfield layer is redrawn
+// when it is used next, also after a reset in menu or pause
+void handleRenderEvent() {
+	// render targets or the whole device lost their content
+	if (gEvent.type == SDL_RENDER_TARGETS_RESET || gEvent.type == SDL_RENDER_DEVICE_RESET) {
+		gPlayfieldLayerLevel = 0;
 	}
-	checkLoss();
 }
 
-void changeFoculBlock() {
-	Square** squares = gFocusBlock->getSquares();
-	// add squares into vector gOldSquares
-	for (int i = 0; i < 4; i++) {
-		gOldSquares.push_back(squares[i]);
-	}
-	// change block
-	delete gFocusBlock;
-	gFocusBlock = gNextBlock;
-	gFocusBlock->setupSquares(BLOCK_START_X, BLOCK_START_Y);
+// check if main game is the current state
+bool isGameRunning() {
+	return !gStageStack.empty() && gStageStack.top().StatePointer == Game;
+}
 
-	// create new next block
-	gNextBlock = new Block(NEXT_BLOCK_CIRCLE_X, NEXT_BLOCK_CIRCLE_Y, &gSprite, (BlockTypes)(rand() % BLOCK_TOTAL));
+// input of player, ignored while a replay or the autoplayer drives the game
+void handlePlayerInput(GameInput input) {
+	if (gReplaying || gAutoPlaying) {
+		return;
+	}
+	applyInput(input);
 }
 
-int checkCompletedLindes() {
-	int lineNums = 0;
-
-	// all game area have 13 lines
-	int line[13] = { 0 };// per line has how many squares
-	int accumulationLines[13] = {0};// per line and before it has how many completed lines
-	int distance = SQUARE_MEDIAN * 2;
-	// bottom and top square center hight
-	int bottom = GAME_AREA_BOTTOM - SQUARE_MEDIAN;
-	int top = bottom - 12 * distance;
-
-	int row;
-	// count squares in line
-	for (int i = 0; i < gOldSquares.size(); i++) {
-		row = (gOldSquares[i]->getCenterY() - top) / distance;
-		line[row]++;
-	}
-	// count completed lines
-	for (row = 0; row < 13; row++) {
-		if (line[row] == SQUARES_PER_ROW) {
-			lineNums++;
-		}
-		accumulationLines[row] = lineNums;
-	}
-	// delete completed lines
-	for (int i = 0; i < gOldSquares.size(); i++) {
-		row = (gOldSquares[i]->getCenterY() - top) / distance;
-		// check if it is in a completed lines
-		if (line[row] == SQUARES_PER_ROW) {
-			delete gOldSquares[i];
-			gOldSquares.erase(gOldSquares.begin() + i);
-			i--;// for erase a element
-		} else {
-			// move down
-			int y = gOldSquares[i]->getCenterY();
-			y += (lineNums - accumulationLines[row])*distance;
-			gOldSquares[i]->setCenterY(y);
-		}
+// record and apply input
+void applyInput(GameInput input) {
+	if (input == INPUT_NONE) {
+		return;
 	}
+	gReplay.record(gGame.getTicks(), input);
+	handleGameEvents(gGame.handleInput(input));
+}
 
-	return lineNums;
+// seed for a new game, differs for games started in the same second
+uint64_t newSeed() {
+	return ((uint64_t)time(0) << 32) ^ SDL_GetPerformanceCounter();
 }
 
-void checkWin() {
-	if (gLevel > LEVEL_NUMS) {
-		// clear entity
-		for (int i = 0; i < gOldSquares.size(); i++) {
-			delete gOldSquares[i];
-		}
-		gOldSquares.clear();
-		// set score and level
-		gScore = 0;
-		gLevel = 1;
-		gFocusBlockSpeed = INITIAL_SPEED;
-		// clear game state
-		while (!gStageStack.empty()) {
-			gStageStack.pop();
-		}
-		StateStruct winState;
-		winState.StatePointer = GameWin;
-		gStageStack.push(winState);
+// play effects and change state for game events
+void handleGameEvents(int events) {
+	if (events & EVENT_MOVED) {
 		// play effect
-		Mix_PlayChannel(-1, gWinSound, 0);
+		Mix_PlayChannel(-1, gKeydownSound, 0);
 	}
-}
-
-void checkLoss() {
-	if (checkEntityCollisions(gFocusBlock, DOWN)) {
-		// clear entity
-		for (int i = 0; i < gOldSquares.size(); i++) {
-			delete gOldSquares[i];
-		}
-		gOldSquares.clear();
-		// set score and level
-		gScore = 0;
-		gLevel = 1;
-		gFocusBlockSpeed = INITIAL_SPEED;
+	if (events & EVENT_BLOCKED) {
+		// play effect
+		Mix_PlayChannel(-1, gCollisionSound, 0);
+	}
+	if (events & EVENT_LINES_CLEARED) {
+		// play effect
+		Mix_PlayChannel(-1, gEliminateSound, 0);
+	}
+	if (events & (EVENT_WIN | EVENT_LOSS)) {
+		// start a new game for next time
+		newGame();
 		// clear game state
 		while (!gStageStack.empty()) {
 			gStageStack.pop();
 		}
-		
-		StateStruct lossState;
-		lossState.StatePointer = GameLose;
-		gStageStack.push(lossState);
-		// play effect
-		Mix_PlayChannel(-1, gLoseSound, 0);
+		StateStruct endState;
+		if (events & EVENT_WIN) {
+			endState.StatePointer = GameWin;
+			// play effect
+			Mix_PlayChannel(-1, gWinSound, 0);
+		} else {
+			endState.StatePointer = GameLose;
+			// play effect
+			Mix_PlayChannel(-1, gLoseSound, 0);
+		}
+		gStageStack.push(endState);
 	}
 }
 
-void drawBackground() {
-	SDL_Rect clip;
+SDL_Rect getBackgroundClip() {
+	SDL_Rect clip = { LEVEL_ONE_X,LEVEL_ONE_Y,WINDOW_WIDTH,WINDOW_HEIGHT };
 	// select clip rect according to level
-	switch (gLevel)
+	switch (gGame.getLevel())
 	{
 	case 1:
 		clip = { LEVEL_ONE_X,LEVEL_ONE_Y,WINDOW_WIDTH,WINDOW_HEIGHT };
@@ -804,123 +822,119 @@ void drawBackground() {
 	case 4:
 		clip = { LEVEL_FOUR_X,LEVEL_FOUR_Y,WINDOW_WIDTH,WINDOW_HEIGHT };
 		break;
-	case 5:
-		clip = { LEVEL_FIVE_X,LEVEL_FIVE_Y,WINDOW_WIDTH,WINDOW_HEIGHT };
-		break;
 	default:
+		// faster levels keep the last background
+		clip = { LEVEL_FIVE_X,LEVEL_FIVE_Y,WINDOW_WIDTH,WINDOW_HEIGHT };
 		break;
 	}
+	return clip;
+}
+
+void drawBackground() {
+	SDL_Rect clip = getBackgroundClip();
 	// render background
 	gSprite.render(gRenderer, 0, 0, &clip);
 }
 
-bool checkEntityCollisions(Square* square, Direction dir) {
-	int x = square->getCenterX();
-	int y = square->getCenterY();
-	int distance = SQUARE_MEDIAN * 2;
-
-	// get position after move on dir
-	switch (dir)
-	{
-	case LEFT:
-		x -= distance;
-		break;
-	case RIGHT:
-		x += distance;
-		break;
-	case DOWN:
-		y += distance;
-		break;
-	default:
-		break;
-	}
-	// check
-	for (int i = 0; i < gOldSquares.size(); i++) {
-		if (abs(x - gOldSquares[i]->getCenterX()) < distance && abs(y - gOldSquares[i]->getCenterY()) < distance) {
-			return true;
-		}
-	}
-	return false;
+void drawScoreText() {
+	SDL_Color textColor = { 0,0,0 };
+	char text[32];
+	// all three lines in one batch
+	gFont.beginText(&gSquareBatch, gRenderer);
+	snprintf(text, sizeof(text), "Level: %d", gGame.getLevel());
+	gFont.addText(&gSquareBatch, LEVEL_RECT_X, LEVEL_RECT_Y, text, textColor);
+	snprintf(text, sizeof(text), "Score: %d", gGame.getScore());
+	gFont.addText(&gSquareBatch, SCORE_RECT_X, SCORE_RECT_Y, text, textColor);
+	snprintf(text, sizeof(text), "Needed: %d", gGame.getLevel()*POINTS_PER_LEVEL);
+	gFont.addText(&gSquareBatch, NEEDED_SCORE_RECT_X, NEEDED_SCORE_RECT_Y, text, textColor);
+	gSquareBatch.flush();
 }
 
-bool checkEntityCollisions(Block* block, Direction dir) {
-	Square** squares = block->getSquares();
-	for (int i = 0; i < 4; i++) {
-		if (checkEntityCollisions(squares[i], dir)) {
-			return true;
+void drawPlayfield(bool dirtyOnly) {
+	Playfield* playfield = gGame.getPlayfield();
+	int size = playfield->getSquareSize();
+	for (int row = 0; row < playfield->getRows(); row++) {
+		// skip clean rows, visit only set bits of the others
+		if (dirtyOnly && !playfield->isDirtyRow(row)) {
+			continue;
+		}
+		for (uint64_t mask = playfield->getRowMask(row); mask != 0; mask &= mask - 1) {
+			int col = Playfield::getLowestBit(mask);
+			gSquareBatch.add(playfield->xFromColumn(col) - size / 2, playfield->yFromRow(row) - size / 2, size, size, &gBlockClips[playfield->getSquare(col, row)]);
 		}
-		
 	}
-	return false;
 }
 
-bool checkWallCollisions(Square* square, Direction dir) {
-	int x = square->getCenterX();
-	int y = square->getCenterY();
-	int distance = SQUARE_MEDIAN * 2;
+void updatePlayfieldLayer() {
+	Playfield* playfield = gGame.getPlayfield();
+	// level change or lost content redraws whole layer
+	bool redrawAll = gPlayfieldLayerLevel != gGame.getLevel();
+	if (!redrawAll && !playfield->hasDirtyRows()) {
+		return;
+	}
 
-	// check
-	switch (dir)
-	{
-	case LEFT:
-		if (x - distance < GAME_AREA_LEFT) {
-			return true;
-		} else {
-			return false;
-		}
-		break;
-	case RIGHT:
-		if (x + distance > GAME_AREA_RIGHT) {
-			return true;
-		} else {
-			return false;
-		}
-		break;
-	case DOWN:
-		if (y + distance > GAME_AREA_BOTTOM) {
-			return true;
-		} else {
-			return false;
+	gPlayfieldLayer.setAsRenderTarget(gRenderer);
+	SDL_Rect clip = getBackgroundClip();
+	if (redrawAll) {
+		gSprite.render(gRenderer, 0, 0, &clip);
+	} else {
+		// draw background of dirty rows
+		int size = playfield->getSquareSize();
+		int x = playfield->xFromColumn(0) - size / 2;
+		SDL_Rect strip;
+		for (int row = 0; row < playfield->getRows(); row++) {
+			if (playfield->isDirtyRow(row)) {
+				int y = playfield->yFromRow(row) - size / 2;
+				strip = { clip.x + x, clip.y + y, playfield->getColumns() * size, size };
+				gSprite.render(gRenderer, x, y, &strip);
+			}
 		}
-		break;
-	default:
-		break;
 	}
-	return false;
+	// draw squares of dirty rows
+	gSquareBatch.begin(gRenderer, &gSprite);
+	drawPlayfield(!redrawAll);
+	gSquareBatch.flush();
+	SDL_SetRenderTarget(gRenderer, NULL);
+
+	playfield->clearDirtyRows();
+	gPlayfieldLayerLevel = gGame.getLevel();
 }
 
-bool checkWallCollisions(Block* block, Direction dir) {
-	Square** squares = block->getSquares();
+void drawBlock(Block* block) {
+	Playfield* playfield = gGame.getPlayfield();
+	int size = playfield->getSquareSize();
+	BlockPose pose = block->getPose();
 	for (int i = 0; i < 4; i++) {
-		if (checkWallCollisions(squares[i], dir)) {
-			return true;
-		}
+		gSquareBatch.add(playfield->xFromColumn(pose.col[i]) - size / 2, playfield->yFromRow(pose.row[i]) - size / 2, size, size, &gBlockClips[block->getType()]);
+	}
+}
 
+void drawGhostBlock(Block* block, int row) {
+	// squares of focus block moved down to landing row
+	Playfield* playfield = gGame.getPlayfield();
+	int size = playfield->getSquareSize();
+	BlockPose pose = block->getPose();
+	int rows = row - block->getRow();
+	for (int i = 0; i < 4; i++) {
+		gSquareBatch.add(playfield->xFromColumn(pose.col[i]) - size / 2, playfield->yFromRow(pose.row[i] + rows) - size / 2, size, size, &gBlockClips[block->getType()], GHOST_ALPHA);
 	}
-	return false;
 }
 
-bool checkRotationCollisions(Block* block) {
-	// get positions after rotation
-	int* temp = block->getRotatePosition();
-	int x, y;
-	int distance = SQUARE_MEDIAN * 2;
+void drawNextBlock(Block* block, int centerX, int centerY, int median) {
+	BlockPose pose = block->getPose();
+	// center squares on point, median is half of square size
+	int minCol = pose.col[0], maxCol = pose.col[0];
+	int minRow = pose.row[0], maxRow = pose.row[0];
+	for (int i = 1; i < 4; i++) {
+		minCol = min(minCol, pose.col[i]);
+		maxCol = max(maxCol, pose.col[i]);
+		minRow = min(minRow, pose.row[i]);
+		maxRow = max(maxRow, pose.row[i]);
+	}
+	int size = median * 2;
+	int x = centerX - (minCol + maxCol + 1) * median;
+	int y = centerY - (minRow + maxRow + 1) * median;
 	for (int i = 0; i < 4; i++) {
-		x = temp[2 * i];
-		y = temp[2 * i + 1];
-		// check wall
-		if (x < GAME_AREA_LEFT || x > GAME_AREA_RIGHT || y > GAME_AREA_BOTTOM) {
-			delete temp;
-			return true;
-		}
-		// check entity
-		for (int j = 0; j < gOldSquares.size(); j++) {
-			if (abs(x - gOldSquares[j]->getCenterX()) < distance && abs(y - gOldSquares[j]->getCenterY()) < distance) {
-				delete temp;
-				return true;
-			}
-		}
+		gSquareBatch.add(x + pose.col[i] * size, y + pose.row[i] * size, size, size, &gBlockClips[block->getType()]);
 	}
-	delete temp;
-	return false;
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    AllocationCheck.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// counts heap allocations while headless games are played, squares and blocks
+// come from fixed pools, so once a game exists nothing may be allocated, not
+// by moves, locks, line clears, game over, reset or board resize
+//
+// usage: falling_blocks_allocation_check [--games N] [--seed N]
+// exit code is 1 when gameplay allocated
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "../include/AutoPlayer.h"
+#include "../include/Constants.h"
+#include "../include/GameState.h"
+#include "../include/Random.h"
+
+// every global new goes through these, only one thread runs
+static long long sAllocations = 0;
+
+void* operator new(size_t size) {
+	sAllocations++;
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	free(memory);
+}
+
+// play one game to the end, autoplayer or random keys, return ticks
+int playGame(GameState* game, AutoPlayer* player, Random* random, bool autoplay);
+
+
+int main(int argc, char** argv) {
+	int games = 100;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--games") == 0 && hasValue) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else {
+			printf("Usage: %s [--games N] [--seed N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// objects of a session are created before counting starts
+	static GameState game;
+	static AutoPlayer player;
+	Random random(seed);
+	long long before = sAllocations;
+
+	long long ticks = 0;
+	for (int i = 0; i < games; i++) {
+		// half of the games on other board sizes, small enough for the
+		// autoplayer to finish quickly, resizing reuses the same storage
+		if (i % 4 >= 2) {
+			game.setBoardSize(MIN_BOARD_COLUMNS + (int)random.nextInt(20), MIN_BOARD_ROWS + (int)random.nextInt(40));
+		} else {
+			game.setBoardSize(SQUARES_PER_ROW, PLAYFIELD_ROWS);
+		}
+		game.reset(seed + (uint64_t)i * 0x9E3779B97F4A7C15ULL);
+		player.reset(game.getSeed());
+		ticks += playGame(&game, &player, &random, i % 2 == 0);
+	}
+
+	long long allocations = sAllocations - before;
+	printf("Games: %d, ticks: %lld, heap allocations during gameplay: %lld\n", games, ticks, allocations);
+	return allocations == 0 ? 0 : 1;
+}
+
+int playGame(GameState* game, AutoPlayer* player, Random* random, bool autoplay) {
+	int events = EVENT_NONE;
+	// random games are cut, idle keys let them run for a while
+	while (!(events & (EVENT_WIN | EVENT_LOSS)) && game->getTicks() < 100000) {
+		GameInput input;
+		if (autoplay) {
+			input = player->getInput(game);
+		} else {
+			uint32_t number = random->nextInt(8 * (INPUT_TOTAL - 1));
+			input = number < INPUT_TOTAL - 1 ? (GameInput)(INPUT_ROTATE + number) : INPUT_NONE;
+		}
+		events = input != INPUT_NONE ? game->handleInput(input) : EVENT_NONE;
+		events |= game->update();
+	}
+	return game->getTicks();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    CollisionBench.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// times collision queries of the falling block against stacks of growing
+// height, every query is a fixed number of cell lookups, so the time per
+// query should not change with the number of locked squares
+//
+// usage: falling_blocks_collision_bench [--repeat N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/GameState.h"
+
+// inputs that bring the focus block back to where it started
+const GameInput BENCH_INPUTS[] = { INPUT_LEFT, INPUT_RIGHT, INPUT_ROTATE, INPUT_ROTATE, INPUT_ROTATE, INPUT_ROTATE };
+const int BENCH_INPUT_COUNT = sizeof(BENCH_INPUTS) / sizeof(BENCH_INPUTS[0]);
+
+// fill bottom rows of playfield, one hole per row so no line completes
+void buildStack(Playfield* playfield, int height);
+
+// time moves and rotations of the focus block, return nanoseconds per input
+double timeInputs(GameState* game, int repeat, long long* checksum);
+
+// time single cell lookups all over the board, return nanoseconds per lookup
+double timeLookups(Playfield* playfield, int repeat, long long* checksum);
+
+// time stacks on one board size
+void benchBoard(int cols, int rows, int step, int repeat);
+
+
+int main(int argc, char** argv) {
+	int repeat = 200000;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+			repeat = atoi(argv[++i]);
+		} else {
+			printf("Usage: %s [--repeat N]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (repeat <= 0) {
+		printf("Nothing to time!\n");
+		return 2;
+	}
+
+	// default board, and a tall one with many more locked squares
+	benchBoard(SQUARES_PER_ROW, PLAYFIELD_ROWS, 1, repeat);
+	benchBoard(SQUARES_PER_ROW, MAX_BOARD_ROWS, 40, repeat);
+	return 0;
+}
+
+void buildStack(Playfield* playfield, int height) {
+	int cols = playfield->getColumns();
+	int rows = playfield->getRows();
+	for (int row = rows - height; row < rows; row++) {
+		int hole = (row * 7) % cols;
+		for (int col = 0; col < cols; col++) {
+			if (col != hole) {
+				playfield->setSquare(col, row, (BlockTypes)(col % BLOCK_TOTAL));
+			}
+		}
+	}
+}
+
+double timeInputs(GameState* game, int repeat, long long* checksum) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < repeat; pass++) {
+		for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+			*checksum += game->handleInput(BENCH_INPUTS[i]);
+		}
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ((double)repeat * BENCH_INPUT_COUNT);
+}
+
+double timeLookups(Playfield* playfield, int repeat, long long* checksum) {
+	int cols = playfield->getColumns();
+	int rows = playfield->getRows();
+	// same number of lookups on every stack, spread over the whole board
+	long long lookups = (long long)repeat * 4;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int col = 0;
+	int row = 0;
+	for (long long i = 0; i < lookups; i++) {
+		*checksum += playfield->isBlocked(col, row) ? 1 : 0;
+		col = col + 3 < cols ? col + 3 : col + 3 - cols;
+		row = row + 5 < rows ? row + 5 : row + 5 - rows;
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+}
+
+void benchBoard(int cols, int rows, int step, int repeat) {
+	static GameState game;
+	printf("Board %dx%d\n", cols, rows);
+	// stack stays below the rows the block moves in
+	int maxHeight = rows - BLOCK_START_ROW - 4;
+	double lowest = 0;
+	double highest = 0;
+	for (int height = 0; height <= maxHeight; height += step) {
+		game.setBoardSize(cols, rows);
+		game.reset(1);
+		buildStack(game.getPlayfield(), height);
+		long long checksum = 0;
+		double inputNs = timeInputs(&game, repeat, &checksum);
+		double lookupNs = timeLookups(game.getPlayfield(), repeat, &checksum);
+		printf("  stack %3d rows, %5d squares: %6.2f ns per move or rotation, %5.2f ns per cell lookup (checksum %lld)\n",
+			height, height * (cols - 1), inputNs, lookupNs, checksum);
+		lowest = height == 0 || inputNs < lowest ? inputNs : lowest;
+		highest = height == 0 || inputNs > highest ? inputNs : highest;
+	}
+	printf("  slowest stack takes %.2fx the time of the fastest\n", highest / lowest);
+}
\ No newline at end of file
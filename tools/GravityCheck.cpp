@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    GravityCheck.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// checks that every level of the gravity table is played with its gravity,
+// and that on the 20G level every block drops to its landing row in the
+// first tick after it appears, whatever the stack below it looks like
+//
+// usage: falling_blocks_gravity_check [--games N] [--seed N]
+// exit code is 1 when a level falls at the wrong speed
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../include/Constants.h"
+#include "../include/GameState.h"
+#include "../include/Random.h"
+
+// ticks until the first block of a level has fallen one square or landed,
+// rows is set to the squares it fell in that tick, fall to the squares
+// between start row and landing row
+int timeFirstFall(GameState* game, int level, int* rows, int* fall);
+
+// play game at last level with random keys, false when a block
+// does not reach its landing row in its first tick
+bool checkInstantDrop(GameState* game, Random* random, int* blocks);
+
+
+int main(int argc, char** argv) {
+	int games = 200;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--games") == 0 && hasValue) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else {
+			printf("Usage: %s [--games N] [--seed N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	static GameState game;
+	// every level is reached before the game is won, the last one is 20G
+	if (GameState::getLevelGravity(LEVEL_NUMS) != GRAVITY_20G) {
+		printf("Last level %d is not 20G!\n", LEVEL_NUMS);
+		return 1;
+	}
+	for (int level = 1; level <= LEVEL_NUMS; level++) {
+		int gravity = GameState::getLevelGravity(level);
+		int rows = 0;
+		int fall = 0;
+		int ticks = timeFirstFall(&game, level, &rows, &fall);
+		// below 1G a square takes whole ticks, from 1G on the squares
+		// of a tick fall at once, up to the landing row
+		int expectedTicks = gravity < GRAVITY_ONE ? (GRAVITY_ONE + gravity - 1) / gravity : 1;
+		int expectedRows = gravity < GRAVITY_ONE ? 1 : gravity / GRAVITY_ONE;
+		expectedRows = expectedRows < fall ? expectedRows : fall;
+		printf("Level %2d: gravity %7.3f squares per tick, first fall after %2d ticks, %2d squares\n",
+			level, gravity / (double)GRAVITY_ONE, ticks, rows);
+		if (game.getLevel() != level || ticks != expectedTicks || rows != expectedRows) {
+			printf("Level %d falls %d squares after %d ticks, %d squares after %d ticks expected!\n",
+				level, rows, ticks, expectedRows, expectedTicks);
+			return 1;
+		}
+	}
+
+	Random random(seed);
+	int blocks = 0;
+	for (int i = 0; i < games; i++) {
+		game.reset(seed + (uint64_t)i * 0x9E3779B97F4A7C15ULL);
+		game.setLevel(LEVEL_NUMS);
+		if (!checkInstantDrop(&game, &random, &blocks)) {
+			printf("Game %d, block %d does not land in its first tick at 20G!\n", i, game.getBlockCount());
+			return 1;
+		}
+	}
+	printf("Levels: %d, 20G blocks: %d, all land in their first tick\n", LEVEL_NUMS, blocks);
+	return 0;
+}
+
+int timeFirstFall(GameState* game, int level, int* rows, int* fall) {
+	game->reset(1);
+	game->setLevel(level);
+	int start = game->getFocusBlock()->getRow();
+	*fall = game->getLandingRow() - start;
+	int ticks = 0;
+	// a landed block counts as fallen, the slide never ends this early
+	while (game->getFocusBlock()->getRow() == start && game->getLandingRow() != start) {
+		game->update();
+		ticks++;
+	}
+	*rows = game->getFocusBlock()->getRow() - start;
+	return ticks;
+}
+
+bool checkInstantDrop(GameState* game, Random* random, int* blocks) {
+	int events = EVENT_NONE;
+	// first block appears with the game
+	bool spawned = true;
+	while (!(events & (EVENT_WIN | EVENT_LOSS))) {
+		// keys move the block before it drops, and along the stack after,
+		// a hard drop locks it and the next one appears before the tick
+		uint32_t number = random->nextInt(4 * (INPUT_TOTAL - 1));
+		GameInput input = number < INPUT_TOTAL - 1 ? (GameInput)(INPUT_ROTATE + number) : INPUT_NONE;
+		events = input != INPUT_NONE ? game->handleInput(input) : EVENT_NONE;
+		spawned = spawned || (events & EVENT_LOCKED) != 0;
+		int tickEvents = game->update();
+		events |= tickEvents;
+		if (spawned && !game->isOver()) {
+			(*blocks)++;
+			if (game->getFocusBlock()->getRow() != game->getLandingRow()) {
+				return false;
+			}
+		}
+		spawned = (tickEvents & EVENT_LOCKED) != 0;
+	}
+	return true;
+}
\ No newline at end of file
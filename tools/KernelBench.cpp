@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    KernelBench.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// checks the placement kernels against the scalar collision path and
+// times both on boards taken from autoplayed games, on the default board
+// or one of any size, wide boards are tested in several windows
+//
+// usage: falling_blocks_kernel_bench [--boards N] [--repeat N] [--seed N] [--board WxH]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../include/AutoPlayer.h"
+#include "../include/GameState.h"
+#include "../include/PlacementKernels.h"
+
+// collect boards seen by autoplayer after every locked block
+void collectBoards(int boardNums, uint64_t seed, int cols, int rows, std::vector<SearchBoard>* boards);
+
+// drop every block rotation in every column with isColliding and getLandingRow,
+// the path the autoplayer used before the kernels
+void findLandingsReference(SearchBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch);
+
+// check if two batches have the same landings and completed lines
+bool isSameBatch(LandingBatch* first, LandingBatch* second);
+
+
+int main(int argc, char** argv) {
+	int boardNums = 20000;
+	int repeat = 20;
+	uint64_t seed = 1;
+	int cols = SQUARES_PER_ROW;
+	int rows = PLAYFIELD_ROWS;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--boards") == 0 && hasValue) {
+			boardNums = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--repeat") == 0 && hasValue) {
+			repeat = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--board") == 0 && hasValue &&
+			sscanf(argv[++i], "%dx%d", &cols, &rows) == 2) {
+		} else {
+			printf("Usage: %s [--boards N] [--repeat N] [--seed N] [--board WxH]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (boardNums <= 0 || repeat <= 0) {
+		printf("No boards to test!\n");
+		return 2;
+	}
+	if (cols < MIN_BOARD_COLUMNS || cols > MAX_BOARD_COLUMNS || rows < MIN_BOARD_ROWS || rows > MAX_BOARD_ROWS) {
+		printf("Board must be %d to %d columns and %d to %d rows!\n", MIN_BOARD_COLUMNS, MAX_BOARD_COLUMNS, MIN_BOARD_ROWS, MAX_BOARD_ROWS);
+		return 2;
+	}
+
+	std::vector<SearchBoard> boards;
+	collectBoards(boardNums, seed, cols, rows, &boards);
+	std::vector<KernelBoard> kernelBoards(boards.size());
+	for (size_t i = 0; i < boards.size(); i++) {
+		PlacementKernels::loadBoard(boards[i].rows, boards[i].columnCount, boards[i].rowCount, &kernelBoards[i]);
+	}
+	KernelLevel supported = PlacementKernels::getSupportedLevel();
+	printf("Boards: %d (%dx%d), supported kernels up to %s\n", (int)boards.size(), cols, rows, PlacementKernels::getLevelName(supported));
+
+	// every kernel has to agree with reference before it is timed
+	for (int level = KERNEL_SCALAR; level <= supported; level++) {
+		for (size_t i = 0; i < boards.size(); i++) {
+			for (int type = 0; type < BLOCK_TOTAL; type++) {
+				for (int rotation = 0; rotation < 4; rotation++) {
+					LandingBatch expected;
+					LandingBatch batch;
+					findLandingsReference(&boards[i], (BlockTypes)type, rotation, BLOCK_START_ROW, &expected);
+					PlacementKernels::findLandings((KernelLevel)level, &kernelBoards[i], (BlockTypes)type, rotation, BLOCK_START_ROW, &batch);
+					if (!isSameBatch(&expected, &batch)) {
+						printf("Kernel %s differs on board %d, block %d, rotation %d!\n",
+							PlacementKernels::getLevelName((KernelLevel)level), (int)i, type, rotation);
+						return 1;
+					}
+				}
+			}
+		}
+	}
+
+	// checksum keeps the compiler from dropping unused results
+	long long batchNums = (long long)boards.size() * BLOCK_TOTAL * 4 * repeat;
+	double referenceNs = 0;
+	for (int level = -1; level <= supported; level++) {
+		long long checksum = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < repeat; pass++) {
+			for (size_t i = 0; i < boards.size(); i++) {
+				for (int type = 0; type < BLOCK_TOTAL; type++) {
+					for (int rotation = 0; rotation < 4; rotation++) {
+						LandingBatch batch;
+						if (level < 0) {
+							findLandingsReference(&boards[i], (BlockTypes)type, rotation, BLOCK_START_ROW, &batch);
+						} else {
+							PlacementKernels::findLandings((KernelLevel)level, &kernelBoards[i], (BlockTypes)type, rotation, BLOCK_START_ROW, &batch);
+						}
+						checksum += batch.rows[0] + batch.cleared[batch.count - 1];
+					}
+				}
+			}
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / batchNums;
+		if (level < 0) {
+			referenceNs = ns;
+			printf("%-10s %8.1f ns per rotation, all columns (checksum %lld)\n", "reference", ns, checksum);
+		} else {
+			printf("%-10s %8.1f ns per rotation, all columns, %.2fx reference (checksum %lld)\n",
+				PlacementKernels::getLevelName((KernelLevel)level), ns, referenceNs / ns, checksum);
+		}
+	}
+	return 0;
+}
+
+void collectBoards(int boardNums, uint64_t seed, int cols, int rows, std::vector<SearchBoard>* boards) {
+	for (int game = 0; (int)boards->size() < boardNums; game++) {
+		GameState state;
+		AutoPlayer player;
+		state.setBoardSize(cols, rows);
+		state.reset(seed + (uint64_t)game * 0x9E3779B97F4A7C15ULL);
+		player.reset(seed);
+		int blockCount = state.getBlockCount();
+		int events = EVENT_NONE;
+		while (!(events & (EVENT_WIN | EVENT_LOSS)) && (int)boards->size() < boardNums) {
+			GameInput input = player.getInput(&state);
+			events = input != INPUT_NONE ? state.handleInput(input) : EVENT_NONE;
+			events |= state.update();
+			if (state.getBlockCount() != blockCount) {
+				blockCount = state.getBlockCount();
+				SearchBoard board;
+				AutoPlayer::copyBoard(state.getPlayfield(), &board);
+				boards->push_back(board);
+			}
+		}
+	}
+}
+
+void findLandingsReference(SearchBoard* board, BlockTypes type, int rotation, int row, LandingBatch* batch) {
+	batch->firstCol = -BLOCK_MASKS.left[type][rotation];
+	batch->count = board->columnCount - (BLOCK_MASKS.right[type][rotation] - BLOCK_MASKS.left[type][rotation]);
+	for (int lane = 0; lane < batch->count; lane++) {
+		int col = batch->firstCol + lane;
+		batch->rows[lane] = (int16_t)LANDING_BLOCKED;
+		batch->cleared[lane] = 0;
+		if (AutoPlayer::isColliding(board, type, rotation, col, row)) {
+			continue;
+		}
+		int landing = AutoPlayer::getLandingRow(board, type, rotation, col, row);
+		batch->rows[lane] = (int16_t)landing;
+		for (int boxRow = 0; boxRow < 4; boxRow++) {
+			int boardRow = landing + boxRow;
+			if (boardRow >= 0 && boardRow < board->rowCount &&
+				(board->rows[boardRow] | AutoPlayer::getRowMask(type, rotation, boxRow, col)) == board->fullRowMask) {
+				batch->cleared[lane] |= 1 << boxRow;
+			}
+		}
+	}
+}
+
+bool isSameBatch(LandingBatch* first, LandingBatch* second) {
+	if (first->firstCol != second->firstCol || first->count != second->count) {
+		return false;
+	}
+	for (int lane = 0; lane < first->count; lane++) {
+		if (first->rows[lane] != second->rows[lane] || first->cleared[lane] != second->cleared[lane]) {
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    LineClearCheck.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// checks the in place line clear of Playfield against the square list line
+// clear the game used before Playfield, on a corpus of generated board states,
+// every board is filled in a few rounds with completed lines anywhere in the
+// stack, adjacent or not, and squares, heights, holes and wells must match
+//
+// usage: falling_blocks_line_clear_check [--boards N] [--seed N]
+// exit code is 1 when a board differs from the reference
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../include/Constants.h"
+#include "../include/Playfield.h"
+#include "../include/Random.h"
+
+// locked square of the old game, which kept every square in a list
+struct ReferenceSquare {
+	int col;
+	int row;
+	int type;
+};
+
+// locked squares in the order they were added
+typedef std::vector<ReferenceSquare> ReferenceBoard;
+
+// fill random empty cells and whole rows into both boards
+void fillBoard(Random* random, Playfield* playfield, ReferenceBoard* reference);
+
+// delete completed lines the way the old checkCompletedLindes did, count
+// squares per row, then delete squares of full rows and move every other
+// square down by the full rows below it, return number of deleted rows
+int clearReference(ReferenceBoard* reference, int cols, int rows);
+
+// check if playfield has the squares and metrics of reference
+bool isSameBoard(Playfield* playfield, ReferenceBoard* reference);
+
+
+int main(int argc, char** argv) {
+	int boardNums = 20000;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--boards") == 0 && hasValue) {
+			boardNums = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else {
+			printf("Usage: %s [--boards N] [--seed N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	Random random(seed);
+	// one playfield for every board, it never allocates
+	static Playfield playfield;
+	long long lines = 0;
+	int rounds = 0;
+	for (int board = 0; board < boardNums; board++) {
+		// every other board has the default size
+		int cols = SQUARES_PER_ROW;
+		int rows = PLAYFIELD_ROWS;
+		if (board % 2 == 1) {
+			cols = MIN_BOARD_COLUMNS + (int)random.nextInt(MAX_BOARD_COLUMNS - MIN_BOARD_COLUMNS + 1);
+			rows = MIN_BOARD_ROWS + (int)random.nextInt(MAX_BOARD_ROWS - MIN_BOARD_ROWS + 1);
+		}
+		playfield.resize(cols, rows);
+		ReferenceBoard reference;
+
+		// rows left from earlier rounds stay, so the clear only sees
+		// rows filled since the last one
+		int roundNums = 1 + (int)random.nextInt(4);
+		for (int round = 0; round < roundNums; round++) {
+			fillBoard(&random, &playfield, &reference);
+			int cleared = playfield.clearCompletedLines();
+			int expected = clearReference(&reference, cols, rows);
+			if (cleared != expected || !isSameBoard(&playfield, &reference)) {
+				printf("Board %d (%dx%d), round %d differs: %d lines cleared, %d expected!\n",
+					board, cols, rows, round, cleared, expected);
+				return 1;
+			}
+			lines += cleared;
+			rounds++;
+		}
+	}
+	printf("Boards: %d, rounds: %d, lines cleared: %lld, all match reference\n", boardNums, rounds, lines);
+	return 0;
+}
+
+void fillBoard(Random* random, Playfield* playfield, ReferenceBoard* reference) {
+	int rows = playfield->getRows();
+	int cols = playfield->getColumns();
+	// stack reaches a random height, lower rows are fuller
+	int height = 1 + (int)random->nextInt(rows);
+	for (int row = rows - height; row < rows; row++) {
+		uint32_t kind = random->nextInt(8);
+		for (int col = 0; col < cols; col++) {
+			// some rows complete, some miss one square, others are sparse
+			bool filled = kind < 3 || (kind < 5 ? col != (int)random->nextInt(cols) : random->nextInt(3) == 0);
+			// squares of earlier rounds stay, a cell has one square
+			if (filled && !playfield->isOccupied(col, row)) {
+				BlockTypes type = (BlockTypes)random->nextInt(BLOCK_TOTAL);
+				playfield->setSquare(col, row, type);
+				ReferenceSquare square = { col, row, type };
+				reference->push_back(square);
+			}
+		}
+	}
+}
+
+int clearReference(ReferenceBoard* reference, int cols, int rows) {
+	int lineNums = 0;
+	std::vector<int> line(rows, 0);// per line has how many squares
+	std::vector<int> accumulationLines(rows, 0);// per line and before it has how many completed lines
+
+	// count squares in line
+	for (size_t i = 0; i < reference->size(); i++) {
+		line[(*reference)[i].row]++;
+	}
+	// count completed lines
+	for (int row = 0; row < rows; row++) {
+		if (line[row] == cols) {
+			lineNums++;
+		}
+		accumulationLines[row] = lineNums;
+	}
+	// delete completed lines, squares are packed in place instead of
+	// erased one by one, so large boards stay fast, their order is kept
+	size_t kept = 0;
+	for (size_t i = 0; i < reference->size(); i++) {
+		ReferenceSquare square = (*reference)[i];
+		if (line[square.row] == cols) {
+			continue;
+		}
+		// move down
+		square.row += lineNums - accumulationLines[square.row];
+		(*reference)[kept++] = square;
+	}
+	reference->resize(kept);
+
+	return lineNums;
+}
+
+bool isSameBoard(Playfield* playfield, ReferenceBoard* reference) {
+	int rows = playfield->getRows();
+	int cols = playfield->getColumns();
+	// block type of every cell, -1 for empty cells
+	std::vector<std::vector<int> > cells(rows, std::vector<int>(cols, -1));
+	for (size_t i = 0; i < reference->size(); i++) {
+		ReferenceSquare square = (*reference)[i];
+		if (cells[square.row][square.col] >= 0) {
+			return false;
+		}
+		cells[square.row][square.col] = square.type;
+	}
+	for (int row = 0; row < rows; row++) {
+		int fill = 0;
+		for (int col = 0; col < cols; col++) {
+			int type = cells[row][col];
+			if (playfield->isOccupied(col, row) != (type >= 0)) {
+				return false;
+			}
+			if (type >= 0 && playfield->getSquare(col, row) != type) {
+				return false;
+			}
+			fill += type >= 0 ? 1 : 0;
+		}
+		if (playfield->getRowFill(row) != fill) {
+			return false;
+		}
+	}
+	// metrics follow the moved rows
+	std::vector<int> heights(cols, 0);
+	for (int col = 0; col < cols; col++) {
+		int top = rows;
+		int squares = 0;
+		for (int row = rows - 1; row >= 0; row--) {
+			if (cells[row][col] >= 0) {
+				top = row;
+				squares++;
+			}
+		}
+		heights[col] = rows - top;
+		if (playfield->getColumnHeight(col) != heights[col] || playfield->getColumnHoles(col) != heights[col] - squares) {
+			return false;
+		}
+	}
+	// a well is as deep as its lower neighbour is higher, walls are full height
+	for (int col = 0; col < cols; col++) {
+		int left = col > 0 ? heights[col - 1] : rows;
+		int right = col < cols - 1 ? heights[col + 1] : rows;
+		int depth = (left < right ? left : right) - heights[col];
+		if (playfield->getWellDepth(col) != (depth > 0 ? depth : 0)) {
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,290 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    ReplayScanner.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// replays every game of replay files or of directories of replay files and
+// checks the result against the recorded one, files are memory mapped, so
+// a corpus of concatenated replays is streamed without reading it into heap
+//
+// usage: falling_blocks_replay_scanner <file or directory>...
+// exit code is 1 when a replay does not match or can not be read
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/Replay.h"
+
+// read only view of a whole file
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+
+	// map file into memory, return false when it can not be mapped
+	bool open(const char* path);
+
+	// unmap file
+	void close();
+
+	// getter
+	const uint8_t* getData();
+	size_t getSize();
+
+	~MappedFile();
+
+private:
+	const uint8_t* mData;
+	size_t mSize;
+#ifdef _WIN32
+	HANDLE mFile;
+	HANDLE mMapping;
+#endif
+};
+
+// totals of a scan
+struct ScanResult {
+	long long replays;
+	long long failures;
+	long long bytes;
+	long long ticks;
+};
+
+// check if path is a directory
+bool isDirectory(const char* path);
+
+// scan file or every file of directory
+void scanPath(const char* path, ScanResult* result);
+void scanDirectory(const char* path, ScanResult* result);
+void scanFile(const char* path, ScanResult* result);
+
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printf("Usage: %s <replay file or directory>...\n", argv[0]);
+		return 2;
+	}
+
+	ScanResult result = { 0, 0, 0, 0 };
+	clock_t start = clock();
+	for (int i = 1; i < argc; i++) {
+		scanPath(argv[i], &result);
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("Replays: %lld, failed: %lld, %.1f MB, %lld ticks in %.2f s\n", result.replays, result.failures,
+		result.bytes / (1024.0 * 1024.0), result.ticks, seconds);
+	if (seconds > 0) {
+		printf("%.0f replays per second, %.0f times faster than real time\n", result.replays / seconds,
+			result.ticks / (double)FRAMES_PER_SECOND / seconds);
+	}
+	return result.failures > 0 ? 1 : 0;
+}
+
+void scanPath(const char* path, ScanResult* result) {
+	if (isDirectory(path)) {
+		scanDirectory(path, result);
+	} else {
+		scanFile(path, result);
+	}
+}
+
+void scanFile(const char* path, ScanResult* result) {
+	MappedFile file;
+	if (!file.open(path)) {
+		printf("%s: unable to map file\n", path);
+		result->failures++;
+		return;
+	}
+
+	// one game is kept for every replay, so nothing is allocated per replay
+	static GameState game;
+	ReplayReader reader;
+	ReplayPlayer player;
+	const uint8_t* data = file.getData();
+	size_t size = file.getSize();
+	size_t offset = 0;
+	while (offset < size) {
+		if (!reader.open(data + offset, size - offset)) {
+			printf("%s+%zu: not a replay\n", path, offset);
+			result->failures++;
+			return;
+		}
+		player.begin(&reader, &game);
+		bool matching = player.run();
+
+		// skip inputs left when the game ended early
+		int tick;
+		GameInput input;
+		while (reader.next(&tick, &input)) {
+		}
+		if (!reader.isValid()) {
+			printf("%s+%zu: replay is cut or damaged\n", path, offset);
+			result->failures++;
+			return;
+		}
+		if (!matching) {
+			printf("%s+%zu: seed %llu, recorded %d ticks, score %d, level %d, lines %d, "
+				"replayed %d ticks, score %d, level %d, lines %d\n", path, offset,
+				(unsigned long long)reader.getSeed(), reader.getEndTick(), reader.getScore(), reader.getLevel(), reader.getLines(),
+				game.getTicks(), game.getScore(), game.getLevel(), game.getLines());
+			result->failures++;
+		}
+		result->replays++;
+		result->ticks += game.getTicks();
+		offset += reader.getSize();
+	}
+	result->bytes += size;
+}
+
+#ifdef _WIN32
+
+bool isDirectory(const char* path) {
+	DWORD attributes = GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+void scanDirectory(const char* path, ScanResult* result) {
+	std::string pattern = std::string(path) + "\\*";
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA(pattern.c_str(), &entry);
+	if (find == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		if (strcmp(entry.cFileName, ".") != 0 && strcmp(entry.cFileName, "..") != 0) {
+			scanPath((std::string(path) + "\\" + entry.cFileName).c_str(), result);
+		}
+	} while (FindNextFileA(find, &entry));
+	FindClose(find);
+}
+
+MappedFile::MappedFile():
+	mData(NULL),mSize(0),mFile(INVALID_HANDLE_VALUE),mMapping(NULL){
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+	mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping == NULL) {
+		close();
+		return false;
+	}
+	mData = (const uint8_t*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if (mData == NULL) {
+		close();
+		return false;
+	}
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close() {
+	if (mData != NULL) {
+		UnmapViewOfFile(mData);
+		mData = NULL;
+	}
+	if (mMapping != NULL) {
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE) {
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+
+#else
+
+bool isDirectory(const char* path) {
+	struct stat status;
+	return stat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+void scanDirectory(const char* path, ScanResult* result) {
+	DIR* directory = opendir(path);
+	if (directory == NULL) {
+		return;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(directory)) != NULL) {
+		if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+			scanPath((std::string(path) + "/" + entry->d_name).c_str(), result);
+		}
+	}
+	closedir(directory);
+}
+
+MappedFile::MappedFile():
+	mData(NULL),mSize(0){
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+	int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0) {
+		::close(file);
+		return false;
+	}
+	void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping stays valid without the descriptor
+	::close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	// pages are read once from front to back
+	madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+	mData = (const uint8_t*)data;
+	mSize = (size_t)status.st_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (mData != NULL) {
+		munmap((void*)mData, mSize);
+		mData = NULL;
+	}
+	mSize = 0;
+}
+
+#endif
+
+const uint8_t* MappedFile::getData() {
+	return mData;
+}
+
+size_t MappedFile::getSize() {
+	return mSize;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
\ No newline at end of file
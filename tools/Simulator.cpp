@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////////////////
+// Project: Game Framework
+// File:    Simulator.cpp
+//////////////////////////////////////////////////////////////////////////////////
+
+// plays many independent games on all cores and prints statistics,
+// used to tune score and speed constants
+//
+// usage: falling_blocks_sim [--games N] [--threads N] [--seed N]
+//                           [--policy search|auto|random|idle] [--max-ticks N]
+//                           [--board WxH]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../include/AutoPlayer.h"
+#include "../include/Constants.h"
+#include "../include/GameState.h"
+#include "../include/GamePolicy.h"
+#include "../include/Random.h"
+#include "../include/SearchPlayer.h"
+#include "../include/ThreadPool.h"
+
+// presses random keys, a baseline for other policies
+class RandomPolicy : public GamePolicy
+{
+public:
+	void reset(uint64_t seed) {
+		mRandom.seed(seed);
+	}
+
+	GameInput getInput(GameState* /*game*/) {
+		// about one key every eight ticks
+		uint32_t number = mRandom.nextInt(8 * (INPUT_TOTAL - 1));
+		if (number >= INPUT_TOTAL - 1) {
+			return INPUT_NONE;
+		}
+		return (GameInput)(INPUT_ROTATE + number);
+	}
+
+private:
+	Random mRandom;
+};
+
+// never presses a key
+class IdlePolicy : public GamePolicy
+{
+public:
+	void reset(uint64_t /*seed*/) {
+	}
+
+	GameInput getInput(GameState* /*game*/) {
+		return INPUT_NONE;
+	}
+};
+
+// simulation settings
+struct SimulationSettings {
+	int games;
+	int threads;
+	uint64_t seed;
+	const char* policy;
+	int maxTicks;
+	int columns;
+	int rows;
+};
+
+// result of one game
+struct GameResult {
+	int score;
+	int level;
+	int lines;
+	int ticks;
+	bool won;
+	bool lost;
+};
+
+// create policy by name, NULL for unknown names
+GamePolicy* createPolicy(const char* name);
+
+// play one game to the end
+void playGame(SimulationSettings* settings, int index, GameResult* result);
+
+// print statistics of all games
+void printResults(std::vector<GameResult>* results, double seconds, int threads);
+
+
+int main(int argc, char** argv) {
+	SimulationSettings settings = { 10000, 0, 1, "random", 1000000, SQUARES_PER_ROW, PLAYFIELD_ROWS };
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--games") == 0 && hasValue) {
+			settings.games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+			settings.threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+			settings.seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--policy") == 0 && hasValue) {
+			settings.policy = argv[++i];
+		} else if (strcmp(argv[i], "--max-ticks") == 0 && hasValue) {
+			settings.maxTicks = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--board") == 0 && hasValue &&
+			sscanf(argv[++i], "%dx%d", &settings.columns, &settings.rows) == 2) {
+		} else {
+			printf("Usage: %s [--games N] [--threads N] [--seed N] [--policy search|auto|random|idle] [--max-ticks N] [--board WxH]\n", argv[0]);
+			return 2;
+		}
+	}
+	GamePolicy* policy = createPolicy(settings.policy);
+	if (policy == NULL || settings.games <= 0) {
+		printf("Unknown policy %s or no games!\n", settings.policy);
+		return 2;
+	}
+	delete policy;
+	if (settings.columns < MIN_BOARD_COLUMNS || settings.columns > MAX_BOARD_COLUMNS ||
+		settings.rows < MIN_BOARD_ROWS || settings.rows > MAX_BOARD_ROWS) {
+		printf("Board must be %d to %d columns and %d to %d rows!\n", MIN_BOARD_COLUMNS, MAX_BOARD_COLUMNS, MIN_BOARD_ROWS, MAX_BOARD_ROWS);
+		return 2;
+	}
+
+	// every game writes only its own result, nothing is shared while playing
+	std::vector<GameResult> results(settings.games);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int threads;
+	{
+		ThreadPool pool(settings.threads);
+		threads = pool.getThreadCount();
+		for (int i = 0; i < settings.games; i++) {
+			GameResult* result = &results[i];
+			pool.submit([&settings, i, result] { playGame(&settings, i, result); });
+		}
+		pool.wait();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printResults(&results, seconds, threads);
+	return 0;
+}
+
+GamePolicy* createPolicy(const char* name) {
+	if (strcmp(name, "search") == 0) {
+		// games already run in parallel, search on one thread without
+		// time budget so results repeat
+		SearchPlayer* player = new SearchPlayer();
+		player->setTimeBudget(0);
+		player->setDepth(2, true);
+		return player;
+	}
+	if (strcmp(name, "auto") == 0) {
+		return new AutoPlayer();
+	}
+	if (strcmp(name, "random") == 0) {
+		return new RandomPolicy();
+	}
+	if (strcmp(name, "idle") == 0) {
+		return new IdlePolicy();
+	}
+	return NULL;
+}
+
+void playGame(SimulationSettings* settings, int index, GameResult* result) {
+	// own game and policy, seeded from game index so runs repeat
+	uint64_t seed = settings->seed + (uint64_t)index * 0x9E3779B97F4A7C15ULL;
+	GameState game;
+	game.setBoardSize(settings->columns, settings->rows);
+	game.reset(seed);
+	GamePolicy* policy = createPolicy(settings->policy);
+	policy->reset(seed);
+
+	int events = EVENT_NONE;
+	while (!(events & (EVENT_WIN | EVENT_LOSS)) && game.getTicks() < settings->maxTicks) {
+		GameInput input = policy->getInput(&game);
+		// a hard drop can end the game before the tick
+		events = input != INPUT_NONE ? game.handleInput(input) : EVENT_NONE;
+		events |= game.update();
+	}
+	delete policy;
+
+	result->score = game.getScore();
+	result->level = game.getLevel();
+	result->lines = game.getLines();
+	result->ticks = game.getTicks();
+	result->won = (events & EVENT_WIN) != 0;
+	result->lost = (events & EVENT_LOSS) != 0;
+}
+
+void printResults(std::vector<GameResult>* results, double seconds, int threads) {
+	int games = (int)results->size();
+	std::vector<int> scores(games);
+	long long lines = 0;
+	long long ticks = 0;
+	int wins = 0;
+	// only lost games count for lines before loss, not won or cut games
+	long long lostLines = 0;
+	int losses = 0;
+	// games ending on every level, won games reach LEVEL_NUMS + 1
+	std::vector<int> levels(LEVEL_NUMS + 2, 0);
+	for (int i = 0; i < games; i++) {
+		GameResult* result = &(*results)[i];
+		scores[i] = result->score;
+		lines += result->lines;
+		ticks += result->ticks;
+		wins += result->won ? 1 : 0;
+		if (result->lost) {
+			lostLines += result->lines;
+			losses++;
+		}
+		levels[std::min(std::max(result->level, 1), LEVEL_NUMS + 1)]++;
+	}
+	std::sort(scores.begin(), scores.end());
+
+	printf("Games: %d on %d threads in %.2f s, %.0f games per second, %.0f times faster than real time\n",
+		games, threads, seconds, games / seconds, ticks / (double)FRAMES_PER_SECOND / seconds);
+	printf("Score: min %d, p10 %d, p50 %d, p90 %d, max %d\n", scores[0], scores[games / 10],
+		scores[games / 2], scores[games * 9 / 10], scores[games - 1]);
+	printf("Lines per game: %.2f, game length: %.1f s\n", lines / (double)games, ticks / (double)games / FRAMES_PER_SECOND);
+	if (losses > 0) {
+		printf("Lines before loss: %.2f over %d lost games\n", lostLines / (double)losses, losses);
+	} else {
+		printf("Lines before loss: no game lost\n");
+	}
+	for (int level = 1; level <= LEVEL_NUMS; level++) {
+		printf("Level %d: %d games (%.1f%%)\n", level, levels[level], levels[level] * 100.0 / games);
+	}
+	printf("Won (level > %d): %d games (%.1f%%)\n", LEVEL_NUMS, wins, wins * 100.0 / games);
+}
\ No newline at end of file